@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////////
+// ChunkedRing.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #3
+//
+// LinearQueue<T, ChunkedRing> is a second implementation of the LinearQueue api,
+// which keeps the items in contiguous chunks instead of one node each:
+//     LinearQueue<T, ChunkedRing>()  create and returns a new empty queue
+//     isEmpty(), size(), enQueue(d), deQueue(), peek(), replace(d)
+//                                    just as in LinearQueue.hpp, chainable too
+//
+// the chunks are linked into a ring.  items are enqueued at the tail of the
+// tail chunk and dequeued from the head of the head chunk, and a chunk the head
+// has moved past stays in the ring, to be filled again when the tail comes
+// round to it.  a new chunk is only spliced in after the tail when the next one
+// is still in use, so a queue which stays about the same size stops allocating.
+// the first chunk holds RING_FIRST items, so a queue of a few items stays small,
+// and each new chunk doubles up to about RING_CHUNK bytes.
+//
+// an item never moves once enqueued, so a reference from peek() stays good
+// until that item is dequeued, just as with the linked version.
+///////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CHUNKED_RING
+#define __CHUNKED_RING
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include "LinearQueue.hpp"
+
+#define RING_FIRST 4         // items in a queue's first chunk
+#define RING_CHUNK 4096      // bytes, chunks stop doubling once they are this big
+
+// selects the chunked implementation.  the parameter is unused, it only makes
+// ChunkedRing the same kind of template as the node allocators.
+template <class Node> struct ChunkedRing {};
+
+template <class T>
+class LinearQueue<T, ChunkedRing> {
+    private:
+    // a chunk header followed by room for capacity items
+    struct Chunk {
+        Chunk *next;
+        size_t capacity;
+        T *items() { return reinterpret_cast<T *>(reinterpret_cast<char *>(this) + itemOffset); }
+    };
+    static_assert(alignof(T) <= alignof(std::max_align_t), "chunks are only aligned for ordinary types");
+    static constexpr size_t itemOffset = (sizeof(Chunk) + alignof(T) - 1) / alignof(T) * alignof(T);
+    static constexpr size_t largest = RING_CHUNK / sizeof(T) > RING_FIRST ? RING_CHUNK / sizeof(T) : RING_FIRST;
+
+    Chunk *head, *tail;       // nullptr until the first enQueue
+    size_t headIndex;         // the front item in head
+    size_t tailIndex;         // where the next item goes in tail
+    size_t count;
+
+    static Chunk *newChunk(size_t capacity) {
+        Chunk *chunk = static_cast<Chunk *>(::operator new(itemOffset + capacity * sizeof(T)));
+        chunk->capacity = capacity;
+        return chunk;
+    }
+
+    public:
+    LinearQueue() : head(nullptr), tail(nullptr), headIndex(0), tailIndex(0), count(0) {}
+
+    // dequeue all items, then free the chunks once round the ring
+    ~LinearQueue() {
+        while (!isEmpty()) deQueue();
+        if (head == nullptr) return;
+        Chunk *chunk = head->next;
+        while (chunk != head) {
+            Chunk *next = chunk->next;
+            ::operator delete(chunk);
+            chunk = next;
+        }
+        ::operator delete(head);
+    }
+
+    // copy constructor
+    LinearQueue(const LinearQueue &other) : head(nullptr), tail(nullptr), headIndex(0), tailIndex(0), count(0) {
+        Chunk *chunk = other.head;
+        size_t index = other.headIndex;
+        for (size_t i = 0; i < other.count; i++, index++) {
+            if (index == chunk->capacity) { chunk = chunk->next; index = 0; }
+            enQueue(chunk->items()[index]);
+        }
+    }
+    LinearQueue &operator=(const LinearQueue &) = delete;
+
+    bool isEmpty() const { return count == 0; }
+
+    size_t size() const { return count; }
+
+    // enQueue returns itself to allow chaining
+    LinearQueue& enQueue(const T& data) {
+        if (head == nullptr) {
+            head = tail = newChunk(RING_FIRST);
+            head->next = head;
+        } else if (tailIndex == tail->capacity) {
+            // the next chunk is free unless the head is still in it
+            if (tail->next == head) {
+                Chunk *chunk = newChunk(tail->capacity * 2 < largest ? tail->capacity * 2 : largest);
+                chunk->next = tail->next;
+                tail->next = chunk;
+            }
+            tail = tail->next;
+            tailIndex = 0;
+        }
+        new (tail->items() + tailIndex) T(data);
+        tailIndex++;
+        count++;
+        return *this;
+    }
+
+    // deQueue returns itself to allow chaining
+    LinearQueue& deQueue() {
+        if (isEmpty()) throw std::runtime_error("No element to deQueue.");
+        head->items()[headIndex].~T();
+        headIndex++;
+        count--;
+        // an empty queue starts over at the front of its chunk
+        if (count == 0) { tail = head; headIndex = tailIndex = 0; }
+        else if (headIndex == head->capacity) { head = head->next; headIndex = 0; }
+        return *this;
+    }
+
+    T& peek() const {
+        if (isEmpty()) throw std::runtime_error("No element to peek.");
+        return head->items()[headIndex];
+    }
+
+    LinearQueue& replace(const T& data) {
+        if (isEmpty()) throw std::runtime_error("No element to replace.");
+        head->items()[headIndex] = data;
+        return *this;
+    }
+}; // class LinearQueue<T, ChunkedRing>
+
+#endif
@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////////
+// EpochReclamation.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #3
+//
+// epoch based reclamation, so a lock-free structure can free a node another
+// thread may still be reading.  the api:
+//     EpochGuard g;            while a guard is alive the thread may follow
+//                              pointers into shared nodes
+//     epochRetire(p)           p has been unlinked; it is deleted once no
+//                              guard from before the unlink can still see it
+//
+// there is one global epoch.  a guard announces the epoch it started in, and
+// a retired node goes on the list for the epoch it was retired in.  the epoch
+// only moves on from e once every thread inside a guard has announced e, so
+// when it reaches e + 2 no guard can be older than e + 1, and whatever was
+// retired in e was already unlinked before any of them began.  so each thread
+// needs only three lists, for the epochs mod 3: retiring into a list still
+// holding an older epoch frees that first, and every EPOCH_COLLECT retirements
+// the thread tries to move the epoch on and frees the lists two behind it.  a
+// thread's record is handed on to the next thread when it exits, retired
+// nodes and all.
+///////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __EPOCH_RECLAMATION
+#define __EPOCH_RECLAMATION
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#define EPOCH_COLLECT 64     // retirements between attempts to free old nodes
+
+class EpochDomain {
+    public:
+    struct Retired {
+        void *node;
+        void (*destroy)(void *);
+    };
+
+    // one per thread that has used a guard, never freed, reused after the thread exits
+    struct Record {
+        std::atomic<size_t> announced;   // epoch << 1 | 1 while inside a guard, else 0
+        std::atomic<bool> owned;
+        size_t depth;                    // nested guards
+        std::vector<Retired> retired[3]; // by epoch mod 3
+        size_t retiredEpoch[3];          // the epoch each list holds
+        size_t retirements;
+        Record *next;
+        Record() : announced(0), owned(true), depth(0), retiredEpoch{0, 0, 0}, retirements(0), next(nullptr) {}
+    };
+
+    static EpochDomain &instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // the calling thread's record, claimed the first time it asks
+    Record *record() {
+        struct Owner {
+            Record *record = nullptr;
+            ~Owner() { if (record) record->owned.store(false, std::memory_order_release); }
+        };
+        static thread_local Owner owner;
+        if (owner.record == nullptr) owner.record = claim();
+        return owner.record;
+    }
+
+    void enter(Record *r) {
+        if (r->depth++ > 0) return;
+        r->announced.store(epoch.load(std::memory_order_relaxed) << 1 | 1, std::memory_order_relaxed);
+        // the announcement must be visible before any shared pointer is read
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void exit(Record *r) {
+        if (--r->depth > 0) return;
+        r->announced.store(0, std::memory_order_release);
+    }
+
+    void retire(Record *r, void *node, void (*destroy)(void *)) {
+        size_t current = epoch.load(std::memory_order_acquire);
+        // a list holding another epoch holds one at least three behind
+        if (r->retiredEpoch[current % 3] != current) {
+            release(r->retired[current % 3]);
+            r->retiredEpoch[current % 3] = current;
+        }
+        r->retired[current % 3].push_back({node, destroy});
+        if (++r->retirements % EPOCH_COLLECT == 0) collect(r);
+    }
+
+    // only when no other thread is running: frees everything still retired
+    ~EpochDomain() {
+        for (Record *r = records.load(); r != nullptr;) {
+            for (std::vector<Retired> &list : r->retired) release(list);
+            Record *next = r->next;
+            delete r;
+            r = next;
+        }
+    }
+
+    private:
+    std::atomic<size_t> epoch;
+    std::atomic<Record *> records;
+
+    EpochDomain() : epoch(0), records(nullptr) {}
+
+    Record *claim() {
+        for (Record *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            bool free = false;
+            if (!r->owned.load(std::memory_order_relaxed) &&
+                r->owned.compare_exchange_strong(free, true, std::memory_order_acquire)) return r;
+        }
+        Record *r = new Record();
+        r->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+        return r;
+    }
+
+    // move the epoch on if every guard has caught up with it, then free what
+    // was retired two epochs ago
+    void collect(Record *r) {
+        size_t current = epoch.load(std::memory_order_acquire);
+        bool caughtUp = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (Record *other = records.load(std::memory_order_acquire); other != nullptr; other = other->next) {
+            size_t announced = other->announced.load(std::memory_order_acquire);
+            if ((announced & 1) && (announced >> 1) != current) { caughtUp = false; break; }
+        }
+        if (caughtUp && epoch.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel)) current++;
+        for (size_t list = 0; list < 3; list++)
+            if (r->retiredEpoch[list] + 2 <= current) release(r->retired[list]);
+    }
+
+    static void release(std::vector<Retired> &list) {
+        for (Retired &old : list) old.destroy(old.node);
+        list.clear();
+    }
+}; // class EpochDomain
+
+class EpochGuard {
+    public:
+    EpochGuard() : record(EpochDomain::instance().record()) { EpochDomain::instance().enter(record); }
+    ~EpochGuard() { EpochDomain::instance().exit(record); }
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+
+    private:
+    EpochDomain::Record *record;
+}; // class EpochGuard
+
+template <class Node>
+void epochRetire(Node *node) {
+    EpochDomain &domain = EpochDomain::instance();
+    domain.retire(domain.record(), node, [](void *p) { delete static_cast<Node *>(p); });
+}
+
+#endif
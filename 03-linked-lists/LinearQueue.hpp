@@ -6,6 +6,7 @@
 //
 // this is a templated queue class with the following api:
 //     LinearQueue<T>()      create and returns a new empty queue containing type T
+//     LinearQueue<T, A>()   the same, with its nodes from allocator A (see SlabAllocator.hpp)
 //     bool    isEmpty()     returns true if the queue is empty, false otherwise
 //     size_t  size()        returns number of items in the queue
 //             enQueue(d)    adds item d of type T to end of queue
@@ -24,13 +25,20 @@
 // is inserted.  this allows access to both the front and back of the list with one
 // pointer into the list, and without having to worry about special enqueue condition
 // into an empty list.
+//
+// the nodes come from a slab pool owned by the queue unless another allocator
+// is given, so enQueue and deQueue recycle nodes instead of calling new and
+// delete for each one.  LinearQueue<T, ChunkedRing> is the same api stored in
+// contiguous chunks instead (see ChunkedRing.hpp).
 ///////////////////////////////////////////////////////////////////////////////////
 
 #ifndef __LINEAR_QUEUE
 #define __LINEAR_QUEUE
 #include <memory>
+#include <stdexcept>
+#include "SlabAllocator.hpp"
 
-template <class T>
+template <class T, template <class> class Allocator = SlabNodes>
 class LinearQueue {
     private:
     // this is an individual node in the queue.  It is hidden from the API
@@ -51,22 +59,23 @@ class LinearQueue {
         void  setNext(Node *n)    { next = n; }
     }; // inner struct Node
 
+    Allocator<Node> nodes;
     Node *sentinel;
     size_t count;
 
     public:
     // in an empty queue, the sentinel points to itself like ouroborus
-    LinearQueue() { count = 0; sentinel = new Node(); sentinel->setNext(sentinel); }
+    LinearQueue() { count = 0; sentinel = nodes.create(); sentinel->setNext(sentinel); }
 
     // to destroy the queue, loop through and dequeue all items, then delete the sentinel
     ~LinearQueue() {
         while(!isEmpty()) deQueue();
-        delete sentinel;
+        nodes.destroy(sentinel);
     }
     // copy constructor
     LinearQueue (const LinearQueue &other) {
         count = 0;
-        sentinel = new Node();
+        sentinel = nodes.create();
         sentinel->setNext(sentinel);
         Node *currentOther = (other.sentinel)->getNext();
         while (currentOther != other.sentinel) {
@@ -83,7 +92,7 @@ class LinearQueue {
 
     // enQueue returns itself to allow chaining
     LinearQueue& enQueue(const T& data)  {
-        Node *newSentinel = new Node();
+        Node *newSentinel = nodes.create();
         newSentinel->setNext(sentinel->getNext());
         sentinel->setData(data);
         sentinel->setNext(newSentinel);
@@ -98,7 +107,7 @@ class LinearQueue {
         count--;
         Node *removed = sentinel->getNext();
         sentinel->setNext(removed->getNext());
-        delete removed;
+        nodes.destroy(removed);
         return *this;
     }
 
@@ -114,4 +123,5 @@ class LinearQueue {
     }
 }; // class LinearQueue
 
+#include "ChunkedRing.hpp"
 #endif
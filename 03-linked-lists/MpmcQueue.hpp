@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////////
+// MpmcQueue.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #3
+//
+// a lock-free queue any number of threads can enqueue to and dequeue from at
+// once (Michael and Scott, "Simple, Fast, and Practical Non-Blocking and
+// Blocking Concurrent Queue Algorithms", PODC 1996), with the following api:
+//     MpmcQueue<T>()             create and returns a new empty queue
+//     bool    isEmpty()          true if the queue was empty when it looked
+//             enQueue(d)         adds a copy of d at the back, chainable
+//     std::pair<bool, T> try_deQueue()
+//                                removes the front item and returns it by
+//                                value, with false (and T()) if there was none
+//     bool    try_deQueue(d)     the same, moving the item into d
+//
+// there is no peek() or replace(): a reference to the front item could be
+// dequeued and freed by another thread while it was being used.
+//
+// like LinearQueue it keeps a sentinel node, here at the front: head points to
+// the sentinel and the first item is in the node after it.  dequeueing swings
+// head on to that node, which becomes the new sentinel, and the old sentinel
+// is retired.  enQueue links a new node after the last one with a CAS, and
+// either thread moves tail on to it, so no thread ever waits on another.  nodes
+// are only freed through EpochReclamation.hpp, which is what keeps a dequeuer
+// that is still reading an old head from touching freed memory.
+///////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MPMC_QUEUE
+#define __MPMC_QUEUE
+#include <atomic>
+#include <utility>
+#include "EpochReclamation.hpp"
+
+#define MPMC_CACHELINE 64    // bytes, head and tail are kept this far apart
+
+template <class T>
+class MpmcQueue {
+    private:
+    struct Node {
+        T data;
+        std::atomic<Node *> next;
+        Node() : next(nullptr) {}
+        Node(const T &d) : data(d), next(nullptr) {}
+    }; // inner struct Node
+
+    alignas(MPMC_CACHELINE) std::atomic<Node *> head;
+    alignas(MPMC_CACHELINE) std::atomic<Node *> tail;
+
+    public:
+    // in an empty queue head and tail both point to the sentinel
+    MpmcQueue() {
+        Node *sentinel = new Node();
+        head.store(sentinel, std::memory_order_relaxed);
+        tail.store(sentinel, std::memory_order_relaxed);
+    }
+
+    // only once no other thread is using the queue
+    ~MpmcQueue() {
+        for (Node *node = head.load(std::memory_order_relaxed); node != nullptr;) {
+            Node *next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    bool isEmpty() const {
+        EpochGuard guard;
+        return head.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // enQueue returns itself to allow chaining
+    MpmcQueue& enQueue(const T& data) {
+        Node *node = new Node(data);
+        EpochGuard guard;
+        for (;;) {
+            Node *last = tail.load(std::memory_order_acquire);
+            Node *next = last->next.load(std::memory_order_acquire);
+            if (last != tail.load(std::memory_order_acquire)) continue;
+            if (next != nullptr) {
+                // tail fell behind, help it on
+                tail.compare_exchange_weak(last, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (last->next.compare_exchange_weak(next, node, std::memory_order_release, std::memory_order_relaxed)) {
+                tail.compare_exchange_strong(last, node, std::memory_order_release, std::memory_order_relaxed);
+                return *this;
+            }
+        }
+    }
+
+    bool try_deQueue(T& data) {
+        EpochGuard guard;
+        for (;;) {
+            Node *first = head.load(std::memory_order_acquire);
+            Node *last  = tail.load(std::memory_order_acquire);
+            Node *next  = first->next.load(std::memory_order_acquire);
+            if (first != head.load(std::memory_order_acquire)) continue;
+            if (next == nullptr) return false;
+            if (first == last) {
+                // the item is linked but tail hasn't caught up yet
+                tail.compare_exchange_weak(last, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            // copied before the CAS: once head moves, another dequeuer may
+            // retire next and the data with it
+            T value = next->data;
+            if (head.compare_exchange_weak(first, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                data = std::move(value);
+                epochRetire(first);
+                return true;
+            }
+        }
+    }
+
+    std::pair<bool, T> try_deQueue() {
+        std::pair<bool, T> result(false, T());
+        result.first = try_deQueue(result.second);
+        return result;
+    }
+}; // class MpmcQueue
+
+#endif
@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////////
+// SlabAllocator.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #3
+//
+// node allocators for LinearQueue, picked with its second template parameter:
+//     SlabNodes<Node>           (the default) nodes come from chunks owned by the
+//                               queue and are recycled through free lists, so
+//                               only about one enQueue in a chunk's worth calls
+//                               the system allocator
+//     ShrinkingSlabNodes<Node>  the same, but a chunk whose nodes have all been
+//                               deQueued is given back, keeping one spare
+//     HeapNodes<Node>           new and delete for every node, as before
+//
+// the first SLAB_INLINE nodes live in the allocator itself, inside the queue,
+// so a short-lived queue of a few items never allocates at all.  after that,
+// each chunk is aligned to its own size, so a node finds its chunk by masking
+// its address.  the chunk starts with a header a cache line long, followed by
+// the node slots.  a free slot holds the link of its chunk's free list in place
+// of the node (an intrusive free list; the inline slots have one too), and
+// slots which have never been used are handed out in order without being put
+// on the list first.  chunks with a free slot are kept on one list and full
+// ones on another, so a freed node moves its chunk back in constant time.
+///////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SLAB_ALLOCATOR
+#define __SLAB_ALLOCATOR
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdlib.h>
+
+#define SLAB_CHUNK 1024      // bytes per chunk, a power of two
+#define SLAB_MINNODES 8      // chunks grow past SLAB_CHUNK to hold at least this many nodes
+#define SLAB_CACHELINE 64    // bytes, the chunk header is padded to this
+#define SLAB_INLINE 4        // nodes held in the allocator itself, before any chunk
+
+template <class Node, bool Shrink = false>
+class SlabAllocator {
+    private:
+    struct FreeSlot { FreeSlot *next; };
+    struct Chunk {
+        FreeSlot *free;      // slots given back, most recent first
+        Chunk *prev, *next;  // on the partial or the full list
+        size_t used;         // slots holding a node
+        size_t fresh;        // slots from here on have never been used
+    };
+
+    static constexpr size_t roundUp(size_t n, size_t to) { return (n + to - 1) / to * to; }
+    static constexpr size_t powerOfTwo(size_t n, size_t p = 1) { return p >= n ? p : powerOfTwo(n, 2 * p); }
+    static constexpr size_t headerBytes =
+        roundUp(sizeof(Chunk), alignof(Node) > SLAB_CACHELINE ? alignof(Node) : SLAB_CACHELINE);
+    static constexpr size_t slotBytes = sizeof(Node) > sizeof(FreeSlot) ? sizeof(Node) : sizeof(FreeSlot);
+    static constexpr size_t chunkBytes =
+        powerOfTwo(headerBytes + SLAB_MINNODES * slotBytes > SLAB_CHUNK ? headerBytes + SLAB_MINNODES * slotBytes
+                                                                        : SLAB_CHUNK);
+    static constexpr size_t capacity = (chunkBytes - headerBytes) / slotBytes;
+
+    Chunk *partial, *full;
+    size_t emptyChunks;      // chunks on the partial list with no nodes in use
+    FreeSlot *inlineFree;
+    size_t inlineFresh;
+    alignas(Node) alignas(FreeSlot) unsigned char inlineSlots[SLAB_INLINE * slotBytes];
+
+    public:
+    SlabAllocator() : partial(nullptr), full(nullptr), emptyChunks(0), inlineFree(nullptr), inlineFresh(0) {}
+    ~SlabAllocator() { release(partial); release(full); }
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+    Node *create() {
+        if (inlineFree != nullptr) {
+            void *slot = inlineFree;
+            inlineFree = inlineFree->next;
+            return new (slot) Node();
+        }
+        if (inlineFresh < SLAB_INLINE) return new (inlineSlots + inlineFresh++ * slotBytes) Node();
+        if (partial == nullptr) link(partial, newChunk());
+        Chunk *chunk = partial;
+        if (chunk->used == 0) emptyChunks--;
+        void *slot;
+        if (chunk->free != nullptr) {
+            slot = chunk->free;
+            chunk->free = chunk->free->next;
+        } else slot = reinterpret_cast<char *>(chunk) + headerBytes + chunk->fresh++ * slotBytes;
+        if (++chunk->used == capacity) { unlink(partial, chunk); link(full, chunk); }
+        return new (slot) Node();
+    }
+
+    void destroy(Node *node) {
+        node->~Node();
+        FreeSlot *slot = reinterpret_cast<FreeSlot *>(node);
+        unsigned char *bytes = reinterpret_cast<unsigned char *>(node);
+        if (bytes >= inlineSlots && bytes < inlineSlots + sizeof(inlineSlots)) {
+            slot->next = inlineFree;
+            inlineFree = slot;
+            return;
+        }
+        Chunk *chunk = chunkOf(node);
+        slot->next = chunk->free;
+        chunk->free = slot;
+        if (chunk->used-- == capacity) { unlink(full, chunk); link(partial, chunk); }
+        if (chunk->used == 0) {
+            if (Shrink && emptyChunks > 0) { unlink(partial, chunk); free(chunk); }
+            else emptyChunks++;
+        }
+    }
+
+    private:
+    static Chunk *chunkOf(Node *node) {
+        return reinterpret_cast<Chunk *>(reinterpret_cast<uintptr_t>(node) & ~uintptr_t(chunkBytes - 1));
+    }
+
+    Chunk *newChunk() {
+        void *memory = nullptr;
+        if (posix_memalign(&memory, chunkBytes, chunkBytes) != 0) throw std::bad_alloc();
+        Chunk *chunk = static_cast<Chunk *>(memory);
+        chunk->free  = nullptr;
+        chunk->prev  = chunk->next = nullptr;
+        chunk->used  = 0;
+        chunk->fresh = 0;
+        emptyChunks++;
+        return chunk;
+    }
+
+    static void link(Chunk *&list, Chunk *chunk) {
+        chunk->prev = nullptr;
+        chunk->next = list;
+        if (list != nullptr) list->prev = chunk;
+        list = chunk;
+    }
+
+    static void unlink(Chunk *&list, Chunk *chunk) {
+        if (chunk->prev != nullptr) chunk->prev->next = chunk->next;
+        else list = chunk->next;
+        if (chunk->next != nullptr) chunk->next->prev = chunk->prev;
+    }
+
+    // the queue destroys its nodes first, so only the chunks are left
+    static void release(Chunk *list) {
+        while (list != nullptr) {
+            Chunk *next = list->next;
+            free(list);
+            list = next;
+        }
+    }
+}; // class SlabAllocator
+
+template <class Node> using SlabNodes = SlabAllocator<Node, false>;
+template <class Node> using ShrinkingSlabNodes = SlabAllocator<Node, true>;
+
+template <class Node>
+class HeapNodes {
+    public:
+    Node *create()            { return new Node(); }
+    void  destroy(Node *node) { delete node; }
+}; // class HeapNodes
+
+#endif
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////////
+// SpscQueue.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #3
+//
+// a bounded queue for exactly one producer thread and one consumer thread,
+// with the following api:
+//     SpscQueue<T>(capacity)     create an empty queue holding up to capacity
+//                                items (rounded up to a power of two)
+//     bool   try_enQueue(d)      producer: adds d at the back, false if full
+//     size_t try_enQueue(p, n)   producer: adds up to n items from p[] at once,
+//                                returns how many fit
+//     bool   try_deQueue(d)      consumer: moves the front item into d, false
+//                                if there is none
+//     size_t try_deQueue(p, n)   consumer: moves up to n items into p[] at once,
+//                                returns how many there were
+//     size_t size(), isEmpty()   only exact when neither side is running
+//
+// every call finishes in a bounded number of steps whatever the other thread
+// is doing (wait-free), so a full or empty queue is reported rather than
+// waited out.  the items live in a ring of slots indexed by two counters that
+// only grow: the producer owns tail and the consumer owns head.  each side
+// publishes its counter with one release store per call, so a batch of n items
+// costs the other side a single cache miss.  head and tail sit on separate
+// cache lines, each next to that side's last copy of the other counter, which
+// is only read again when the copy says the queue is full (or empty).
+///////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SPSC_QUEUE
+#define __SPSC_QUEUE
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#define SPSC_CACHELINE 64    // bytes, head and tail are kept this far apart
+#define SPSC_CAPACITY 1024   // items, the default capacity
+
+template <class T>
+class alignas(SPSC_CACHELINE) SpscQueue {
+    public:
+    explicit SpscQueue(size_t capacity = SPSC_CAPACITY)
+        : head(0), cachedTail(0), tail(0), cachedHead(0), mask(powerOfTwo(capacity) - 1),
+          slots(new T[mask + 1]) {}
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    bool try_enQueue(const T &item) { return try_enQueue(&item, 1) == 1; }
+
+    size_t try_enQueue(const T *items, size_t n) {
+        size_t back = tail.load(std::memory_order_relaxed);
+        if (mask + 1 - (back - cachedHead) < n) cachedHead = head.load(std::memory_order_acquire);
+        n = std::min(n, mask + 1 - (back - cachedHead));
+        for (size_t i = 0; i < n; i++) slots[(back + i) & mask] = items[i];
+        tail.store(back + n, std::memory_order_release);
+        return n;
+    }
+
+    bool try_deQueue(T &item) { return try_deQueue(&item, 1) == 1; }
+
+    size_t try_deQueue(T *items, size_t n) {
+        size_t front = head.load(std::memory_order_relaxed);
+        if (cachedTail - front < n) cachedTail = tail.load(std::memory_order_acquire);
+        n = std::min(n, cachedTail - front);
+        for (size_t i = 0; i < n; i++) items[i] = std::move(slots[(front + i) & mask]);
+        head.store(front + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool isEmpty() const { return size() == 0; }
+    size_t capacity() const { return mask + 1; }
+
+    private:
+    static size_t powerOfTwo(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // the consumer's line: its counter and what it last read of tail
+    alignas(SPSC_CACHELINE) std::atomic<size_t> head;
+    size_t cachedTail;
+    // the producer's line: its counter and what it last read of head
+    alignas(SPSC_CACHELINE) std::atomic<size_t> tail;
+    size_t cachedHead;
+    // read-only once constructed
+    alignas(SPSC_CACHELINE) const size_t mask;
+    std::unique_ptr<T[]> slots;
+}; // class SpscQueue
+
+#endif
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////////
+// queueBench.cpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #3
+//
+// contention benchmark for MpmcQueue against a LinearQueue behind a mutex.  for
+// 1, 2, 4, ... 64 threads it splits the same number of operations between the
+// threads, each of which enqueues an item and then dequeues one, over and over,
+// and prints CSV of the time and the operations per microsecond.  every item
+// enqueued has to come out again exactly once; a queue which loses or repeats
+// one is reported.
+//
+// to compile: g++ -std=c++11 -O2 -pthread queueBench.cpp -o queueBench
+//     to run: ./queueBench [pairs] [maxThreads]
+//
+///////////////////////////////////////////////////////////////////////////////////
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LinearQueue.hpp"
+#include "MpmcQueue.hpp"
+
+typedef std::chrono::steady_clock                 Clock;
+typedef std::chrono::duration<double, std::milli> Duration;
+
+// the baseline: every operation takes the one lock
+template <class T>
+class LockedQueue {
+    public:
+    LockedQueue& enQueue(const T& data) {
+        std::lock_guard<std::mutex> guard(lock);
+        queue.enQueue(data);
+        return *this;
+    }
+    bool try_deQueue(T& data) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (queue.isEmpty()) return false;
+        data = queue.peek();
+        queue.deQueue();
+        return true;
+    }
+
+    private:
+    std::mutex lock;
+    LinearQueue<T> queue;
+};
+
+// runs pairs enqueue/dequeue pairs split across threads and returns the
+// milliseconds taken.  items are distinct, so checking their sum and count
+// catches a lost or repeated one.
+template <class Queue>
+double run(size_t pairs, unsigned threads, bool &correct) {
+    Queue queue;
+    std::atomic<bool> go(false);
+    std::vector<unsigned long long> sums(threads, 0), counts(threads, 0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            size_t first = pairs * t / threads, last = pairs * (t + 1) / threads;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            unsigned long long item;
+            for (size_t i = first; i < last; i++) {
+                queue.enQueue(i + 1);
+                if (queue.try_deQueue(item)) { sums[t] += item; counts[t]++; }
+            }
+        });
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &w : workers) w.join();
+    double ms = Duration(Clock::now() - start).count();
+    unsigned long long sum = 0, count = 0, item;
+    for (unsigned t = 0; t < threads; t++) { sum += sums[t]; count += counts[t]; }
+    while (queue.try_deQueue(item)) { sum += item; count++; }
+    correct = count == pairs && sum == (unsigned long long)pairs * (pairs + 1) / 2;
+    return ms;
+}
+
+int main(int argc, char *argv[]) {
+    size_t pairs = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    unsigned maxThreads = argc > 2 ? atoi(argv[2]) : 64;
+    std::cout << "threads,queue,ms,ops_per_us" << std::endl;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        bool correct;
+        for (int q = 0; q < 2; q++) {
+            double ms = q == 0 ? run<MpmcQueue<unsigned long long>>(pairs, threads, correct)
+                               : run<LockedQueue<unsigned long long>>(pairs, threads, correct);
+            std::cout << threads << "," << (q == 0 ? "mpmc" : "mutex") << "," << ms << ","
+                      << 2 * pairs / ms / 1000 << std::endl;
+            if (!correct) std::cout << "[error: items lost or repeated]" << std::endl;
+        }
+    }
+}
@@ -4,9 +4,14 @@
 // Robert Wagner
 // 2016-03-02
 //
-// to compile: g++ -std=c++11 xyzWidget.cpp -o xyzWidget
+// to compile: g++ -std=c++11 -pthread xyzWidget.cpp -o xyzWidget
 //     to run: ./xyzWidget < data.txt
 //         or: ./xyzWidget data.txt
+//         or: ./xyzWidget --pipelined data.txt
+//
+// with --pipelined a reader thread reads and classifies the lines while the
+// main thread runs the store, the two connected by an SpscQueue.  the output
+// is the same either way.
 //
 // note: I re-used a significant amount of the 'driver' code from assn #1 & #2 here
 //
@@ -16,8 +21,11 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <atomic>
+#include <thread>
 #include <boost/format.hpp>
 #include "LinearQueue.hpp"            // my linear linked list queue implementation
+#include "SpscQueue.hpp"              // for the pipelined mode
 
 namespace xyzWidget {
 ///////////////////////////////////////////////////////////////////////////////////
@@ -32,7 +40,7 @@ using std::size_t;
 using boost::format;
 std::ostream& output = std::cout;
 
-typedef LinearQueue<float> fVec;  // use a queue for transaction parameter list
+typedef LinearQueue<float, ChunkedRing> fVec;  // use a queue for transaction parameter list
 
 // enumerate the types of data input records and their # of expected parameters
 typedef enum tTypes { SALE, RECEIPT, PROMO } tTypes;
@@ -65,6 +73,7 @@ class Receipt {
     public:
         Receipt() {}
         ~Receipt() {}
+        Receipt(const Receipt &other) = default;
         Receipt &operator=(const Receipt &other)
             { _qty = other._qty; _price = other._price; return *this; }
 
@@ -86,7 +95,7 @@ class Store {
     int _promoRemaining;
     float _promoCoefficient;
     float _markup;
-    LinearQueue<Receipt> _receiptList;
+    LinearQueue<Receipt, ChunkedRing> _receiptList;
     size_t _saleCount, _promoCount, _receiptCount;
     static size_t _count;
 
@@ -208,6 +217,94 @@ class Store {
   // initialize static variables
     size_t Store::_count        = 0;
 
+////////////////////////////////////////////////////////////////////////////////
+// Transaction - one input line after the reader has looked at it
+// reading and classifying lines (parseLine) is split from running them on the
+// store (execute) so that the two can run on different threads
+////////////////////////////////////////////////////////////////////////////////
+struct Transaction {
+    size_t lineNo;
+    char   tCode;
+    bool   valid;    // tCode is one of TRANSACTIONKEY
+    tTypes tType;
+    string line;
+};
+
+const size_t PIPELINEBATCH    = 32;    // transactions passed between the threads at a time
+const size_t PIPELINECAPACITY = 1024;  // transactions the reader may get ahead by
+
+// false for blank lines and comments, which are skipped
+bool parseLine(size_t lineNo, const string& line, Transaction& t) {
+    if (line.size() == 0) return false;
+    t.tCode = line.front();
+    if (t.tCode == '#') return false;
+    t.lineNo = lineNo;
+    auto tType = TRANSACTIONKEY.find(t.tCode);
+    t.valid = tType != TRANSACTIONKEY.end();
+    if (t.valid) t.tType = tType->second;
+    t.line = line;
+    return true;
+}
+
+// result carries over from line to line, as an error leaves it unchanged
+void execute(Store& S, const Transaction& t, int& result) {
+    if (!t.valid) {
+        output << fmtInvalidToken % t.lineNo % t.tCode;
+        return;
+    }
+    try {
+        //output << fmtInputEcho % line;
+        result = S.handleInput(t.tType, t.line);
+    }
+    catch (std::exception &e) {
+        output << fmtInputError % t.lineNo % e.what();
+    }
+    if (result != Store::SUCCESS) output << "!!!" << endl;
+}
+
+void runSerial(Store& S, std::istream& in) {
+    int result = Store::SUCCESS;
+    size_t lineNo = 0;
+    string line = "";
+    Transaction t;
+    while (std::getline(in, line))
+        if (parseLine(++lineNo, line, t)) execute(S, t, result);
+}
+
+// the reader thread parses batches of lines into the queue, and this thread
+// executes them as they arrive.  neither side blocks on the queue, they yield
+// while it's full or empty.
+void runPipelined(Store& S, std::istream& in) {
+    SpscQueue<Transaction> queue(PIPELINECAPACITY);
+    std::atomic<bool> done(false);
+    std::thread reader([&] {
+        Transaction batch[PIPELINEBATCH];
+        size_t count = 0, lineNo = 0;
+        string line = "";
+        auto publish = [&] {
+            for (size_t sent = 0; sent < count; std::this_thread::yield())
+                if ((sent += queue.try_enQueue(batch + sent, count - sent)) == count) break;
+            count = 0;
+        };
+        while (std::getline(in, line))
+            if (parseLine(++lineNo, line, batch[count]) && ++count == PIPELINEBATCH) publish();
+        publish();
+        done.store(true, std::memory_order_release);
+    });
+    int result = Store::SUCCESS;
+    Transaction batch[PIPELINEBATCH];
+    // once done is seen, one more empty try means everything has been taken
+    for (bool finished = false;;) {
+        size_t count = queue.try_deQueue(batch, PIPELINEBATCH);
+        for (size_t i = 0; i < count; i++) execute(S, batch[i], result);
+        if (count > 0) continue;
+        if (finished) break;
+        finished = done.load(std::memory_order_acquire);
+        if (!finished) std::this_thread::yield();
+    }
+    reader.join();
+}
+
 } // namespace xyzWidget
 
 // main program
@@ -217,37 +314,17 @@ int main(int argc, char* argv[]) {
     using namespace xyzWidget;
     Store S(1.30);
 
+    bool pipelined = false;
     std::ifstream inFile;
     std::istream* inFileP = &std::cin;
-    if (argc > 1) {
-        inFile.open(argv[1]);
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--pipelined") { pipelined = true; continue; }
+        inFile.open(argv[i]);
         if (inFile.good()) inFileP = &inFile;
         else inFile.close();
     }
-    int result = Store::SUCCESS;
-    char tCode = {0};
-    size_t lineNo = 0;
-    string line = "";
-
-    while (std::getline(*inFileP, line)) {
-        ++lineNo;
-        if (line.size() == 0) continue;
-        tCode = line.front();
-        if (tCode == '#') continue;
-        auto tType = TRANSACTIONKEY.find(tCode);
-        if (tType == TRANSACTIONKEY.end()) {
-            output << fmtInvalidToken % lineNo % tCode;
-            continue;
-        }
-        try {
-            //output << fmtInputEcho % line;
-            result = S.handleInput(tType->second, line);
-        }
-        catch (std::exception &e) {
-            output << fmtInputError % lineNo % e.what();
-        }
-        if (result != Store::SUCCESS) output << "!!!" << endl;
-    }
+    if (pipelined) runPipelined(S, *inFileP);
+    else runSerial(S, *inFileP);
     S.finish();
     if (inFile) inFile.close();
 }
@@ -0,0 +1,243 @@
+//////////////////////////////////////////////////////////////////////////////////
+// bufferPool.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// the working buffers of the functors, kept mapped between cells.  every cell
+// copies its functor, and every copy used to allocate fresh buffers and fault
+// in each of their pages, which at large N cost as much as some of the sorts.
+//
+//     bufferPool     mmaps the buffers and touches every page before handing
+//                    one out, so no run takes a page fault on them.  a
+//                    released buffer goes back on a free list and is handed
+//                    out again to the next request it fits closely (at most
+//                    twice the size), so a small request never takes a big
+//                    buffer reserved for something else.  once the free
+//                    buffers pass POOLSPARE bytes the smallest are unmapped.
+//     pooled         an array of elements from the pool, given back when it
+//                    goes out of scope, for the engines' scratch space
+//     pageFaults     the page faults the calling thread has taken so far, for
+//                    the page_faults column
+//
+// with hugePages the pool asks for explicit 2 MiB pages (MAP_HUGETLB), and
+// when none are reserved falls back to advising transparent huge pages.  with
+// numaLocal each buffer is bound to the node of the thread which asked for it
+// (pin the workers so that stays theirs), and is only reused on that node.
+// both are linux only; elsewhere the buffers come from posix_memalign.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __bufferPool__
+#define __bufferPool__
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+
+#define SMALLPAGE (4 << 10)   // bytes, the pages touched to pre-fault a buffer
+#define HUGEPAGE  (2 << 20)   // bytes, buffers are rounded up to this with hugePages
+#define POOLSPARE (size_t(1) << 30) // bytes of free buffers kept mapped
+
+class bufferPool {
+    public:
+    static bufferPool &instance() {
+        static bufferPool pool;
+        return pool;
+    }
+
+    // takes effect for the buffers mapped from then on
+    void configure(bool hugePages, bool numaLocal) {
+        std::lock_guard<std::mutex> guard(lock);
+        this->hugePages = hugePages;
+        this->numaLocal = numaLocal;
+    }
+
+    // a buffer of at least bytes, aligned to a page and with every page mapped
+    void *acquire(size_t bytes) {
+        int node = numaLocal ? currentNode() : -1;
+        std::lock_guard<std::mutex> guard(lock);
+        block b = take(std::max<size_t>(bytes, 1), node);
+        inUse[b.address] = b;
+        return b.address;
+    }
+
+    // makes sure a free buffer is waiting for each of sizes, so that an
+    // engine which acquires its scratch mid-sort doesn't map it on the clock
+    void reserve(std::initializer_list<size_t> sizes) {
+        int node = numaLocal ? currentNode() : -1;
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<block> reserved;
+        size_t bytes = 0;
+        for (size_t size : sizes) {
+            reserved.push_back(take(std::max<size_t>(size, 1), node));
+            reserved.back().owner = std::this_thread::get_id();
+            bytes += reserved.back().bytes;
+        }
+        trim(bytes);
+        spare.insert(spare.end(), reserved.begin(), reserved.end());
+    }
+    void reserve(size_t bytes) { reserve({bytes}); }
+
+    void release(void *address) {
+        if (!address) return;
+        std::lock_guard<std::mutex> guard(lock);
+        auto b = inUse.find(address);
+        if (b == inUse.end()) throw std::runtime_error("released a buffer the pool didn't hand out.");
+        b->second.owner = std::thread::id();
+        spare.push_back(b->second);
+        inUse.erase(b);
+        trim(0);
+    }
+
+    ~bufferPool() {
+        for (const block &b : spare) unmap(b);
+        for (const auto &b : inUse) unmap(b.second);
+    }
+
+    private:
+    struct block {
+        void *address;
+        size_t bytes;   // what was mapped, so at least what was asked for
+        int node;       // -1 unless it was bound to a NUMA node
+        bool mapped;    // from mmap, not posix_memalign
+        std::thread::id owner;  // the thread it was reserved for, if it was
+    };
+    std::mutex lock;
+    std::vector<block> spare;
+    std::map<void *, block> inUse;
+    bool hugePages = false, numaLocal = false;
+
+    bufferPool() {}
+    bufferPool(const bufferPool &) = delete;
+    bufferPool &operator=(const bufferPool &) = delete;
+
+    // the smallest free buffer on the node that fits closely, or a new one.
+    // a buffer reserved by another thread is left for that thread: with
+    // --jobs the workers share the pool.
+    block take(size_t bytes, int node) {
+        const size_t wanted = roundUp(bytes, hugePages ? HUGEPAGE : SMALLPAGE);
+        const std::thread::id self = std::this_thread::get_id(), nobody;
+        auto fit = spare.end();
+        for (auto b = spare.begin(); b != spare.end(); ++b)
+            if (b->node == node && (b->owner == nobody || b->owner == self)
+                && b->bytes >= wanted && b->bytes <= 2 * wanted
+                && (fit == spare.end() || b->bytes < fit->bytes)) fit = b;
+        if (fit == spare.end()) return map(bytes, node);
+        block reused = *fit;
+        spare.erase(fit);
+        return reused;
+    }
+
+    // unmaps the smallest free buffers until they, and extra bytes more, are
+    // no more than POOLSPARE.  with --jobs several sizes are in use at once,
+    // so nothing is dropped just for being smaller than the latest request.
+    void trim(size_t extra) {
+        size_t bytes = extra;
+        for (const block &b : spare) bytes += b.bytes;
+        while (bytes > POOLSPARE && !spare.empty()) {
+            auto smallest = std::min_element(spare.begin(), spare.end(),
+                                             [](const block &a, const block &b) { return a.bytes < b.bytes; });
+            bytes -= smallest->bytes;
+            unmap(*smallest);
+            spare.erase(smallest);
+        }
+    }
+
+    static size_t roundUp(size_t bytes, size_t to) { return (bytes + to - 1) / to * to; }
+
+    block map(size_t bytes, int node) {
+        block b = {nullptr, roundUp(bytes, hugePages ? HUGEPAGE : SMALLPAGE), node, true, std::thread::id()};
+#ifdef __linux__
+        void *address = MAP_FAILED;
+        if (hugePages) address = mmap(nullptr, b.bytes, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (address == MAP_FAILED) {
+            address = mmap(nullptr, b.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (address == MAP_FAILED) throw std::bad_alloc();
+            if (hugePages) madvise(address, b.bytes, MADV_HUGEPAGE);
+        }
+        b.address = address;
+        if (node >= 0) {
+            // bound before the first touch, so the pages are allocated there
+            unsigned long mask[4] = {};
+            if (node < int(8 * sizeof(mask))) {
+                mask[node / (8 * sizeof(long))] = 1ul << (node % (8 * sizeof(long)));
+                syscall(SYS_mbind, address, b.bytes, MPOL_PREFERRED, mask, 8 * sizeof(mask), 0);
+            }
+        }
+#else
+        b.mapped = false;
+        if (posix_memalign(&b.address, SMALLPAGE, b.bytes) != 0) throw std::bad_alloc();
+#endif
+        // pre-fault: one write to every page maps it now rather than mid-sort
+        volatile char *touch = static_cast<char *>(b.address);
+        for (size_t i = 0; i < b.bytes; i += SMALLPAGE) touch[i] = 0;
+        return b;
+    }
+
+    static void unmap(const block &b) {
+#ifdef __linux__
+        if (b.mapped) { munmap(b.address, b.bytes); return; }
+#endif
+        ::free(b.address);
+    }
+
+    static int currentNode() {
+#ifdef __linux__
+        unsigned cpu = 0, node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return int(node);
+#endif
+        return -1;
+    }
+};
+
+// the engines' scratch arrays.  the elements are left uninitialized, so
+// Element should be trivially copyable, like everything in records.hpp.
+template <class Element>
+class pooled {
+    public:
+    pooled() : elements(nullptr), n(0) {}
+    explicit pooled(size_t n) : n(n) {
+        elements = static_cast<Element *>(bufferPool::instance().acquire(n * sizeof(Element)));
+    }
+    pooled(pooled &&other) : elements(other.elements), n(other.n) { other.elements = nullptr; other.n = 0; }
+    pooled &operator=(pooled &&other) {
+        std::swap(elements, other.elements);
+        std::swap(n, other.n);
+        return *this;
+    }
+    pooled(const pooled &) = delete;
+    pooled &operator=(const pooled &) = delete;
+    ~pooled() { bufferPool::instance().release(elements); }
+
+    Element *data() const { return elements; }
+    size_t size() const { return n; }
+    Element &operator[](size_t i) const { return elements[i]; }
+
+    private:
+    Element *elements;
+    size_t n;
+};
+
+// minor and major faults of the calling thread, so a sort run on one thread
+// isn't charged for another worker's.  the faults of the parallel engines'
+// own threads aren't included.
+static inline long pageFaults() {
+#if defined(__linux__) && defined(RUSAGE_THREAD)
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) return usage.ru_minflt + usage.ru_majflt;
+#endif
+    return 0;
+}
+#endif
@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////////////////////
+// cellBudget.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// a time budget for each cell of the sweep, so that one quadratic sort at a
+// large N can't hold up everything else.
+//
+//     overBudget       thrown from the engines' polling points once a cell
+//                      has run past its deadline, aborting it.  every engine
+//                      of sortFunctor.hpp polls except the std_ ones, which
+//                      run to the end once started
+//     complexityModel  fits t = c * f(N) to the times measured for one sort
+//                      and order at smaller sizes, for f = n, n log n and n^2,
+//                      keeping whichever fits best
+//     budgetHistory    the measured times of every sort and order, shared by
+//                      all of the workers of a sweep
+//
+// a cell the model says can't finish in its budget isn't started at all, and
+// an aborted one is reported from the model too.  without enough sizes to fit
+// a model, an aborted cell is reported as over_budget, with no time, and the
+// bigger sizes of its series aren't started.  either way its row is flagged in the
+// extrapolated and model columns.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __cellBudget__
+#define __cellBudget__
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define MODELPOINTS 4   // largest sizes the complexity model is fitted to
+
+struct overBudget : std::runtime_error {
+    overBudget() : std::runtime_error("the cell ran past its time budget.") {}
+};
+
+typedef std::pair<double, double> timedSize;   // N, time
+
+class complexityModel {
+    public:
+    std::string name;   // the growth function which fit best, empty if there was nothing to fit
+    double scale = 0;   // c, so the time at n is c * f(n)
+
+    // fits the measured points, keeping to the models which also predict at
+    // least the lower bound of every size that overran.  a single size fits
+    // every model, and an overrun only bounds it from below, so nothing is
+    // fitted until at least two sizes have been measured.
+    complexityModel(std::vector<timedSize> points, const std::vector<timedSize> &overruns) : overruns(overruns) {
+        std::sort(points.begin(), points.end());
+        if (points.size() > MODELPOINTS) points.erase(points.begin(), points.end() - MODELPOINTS);
+        if (points.empty() || points.front().first == points.back().first) return;
+        double best = 0;
+        bool bestAgrees = false;
+        for (size_t m = 0; m < models; m++) {
+            // least squares on log t with the slope fixed by f leaves only log c
+            double logScale = 0, residual = 0;
+            for (const timedSize &p : points) logScale += std::log(p.second / growth(m, p.first));
+            logScale /= points.size();
+            for (const timedSize &p : points) {
+                double error = std::log(p.second / growth(m, p.first)) - logScale;
+                residual += error * error;
+            }
+            bool agrees = true;
+            for (const timedSize &o : overruns)
+                if (std::exp(logScale) * growth(m, o.first) < o.second) agrees = false;
+            // when none agree, ties go to the faster growing model
+            bool better = agrees ? residual < best : residual <= best;
+            if (name.empty() || (agrees && !bestAgrees) || (agrees == bestAgrees && better)) {
+                best  = residual;
+                bestAgrees = agrees;
+                name  = names()[m];
+                scale = std::exp(logScale);
+                model = m;
+            }
+        }
+    }
+
+    bool fitted() const { return !name.empty(); }
+    // never less than what a size up to n is already known to take
+    double predict(double n) const {
+        double t = scale * growth(model, n);
+        for (const timedSize &o : overruns) if (o.first <= n) t = std::max(t, o.second);
+        return t;
+    }
+
+    private:
+    std::vector<timedSize> overruns;
+    static const size_t models = 3;
+    size_t model = 0;
+
+    static const char *const *names() {
+        static const char *const modelNames[models] = {"n", "nlogn", "n^2"};
+        return modelNames;
+    }
+    static double growth(size_t m, double n) {
+        switch (m) {
+            case 0:  return n;
+            case 1:  return n * std::log2(std::max(n, 2.0));
+            default: return n * n;
+        }
+    }
+};
+
+class budgetHistory {
+    public:
+    void add(const std::string &series, double n, double time) {
+        std::lock_guard<std::mutex> guard(lock);
+        points[series].push_back(timedSize(n, time));
+    }
+
+    // a size of the series which ran out of budget before it could be
+    // measured, so its time is known to be more than atLeast
+    void overran(const std::string &series, double n, double atLeast) {
+        std::lock_guard<std::mutex> guard(lock);
+        overruns[series].push_back(timedSize(n, atLeast));
+    }
+
+    // whether a size below n already ran out of budget, so n would too
+    bool overranBelow(const std::string &series, double n) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (const timedSize &o : overruns[series]) if (o.first < n) return true;
+        return false;
+    }
+
+    // the model of a series from the sizes measured below n and the overruns
+    complexityModel model(const std::string &series, double n) {
+        std::vector<timedSize> below, bounds;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (const timedSize &p : points[series]) if (p.first < n && p.second > 0) below.push_back(p);
+            bounds = overruns[series];
+        }
+        return complexityModel(below, bounds);
+    }
+
+    private:
+    std::mutex lock;
+    std::map<std::string, std::vector<timedSize>> points;
+    std::map<std::string, std::vector<timedSize>> overruns;
+};
+#endif
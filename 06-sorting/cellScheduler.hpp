@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////////////
+// cellScheduler.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// a small fixed-size thread pool which runs the (size, sort, order) cells of the
+// benchmark sweep concurrently.  cells are handed out in index order from an
+// atomic counter, and the main thread writes each result as soon as every cell
+// before it has finished, so the output is in exactly the same order as a
+// serial run no matter which worker finished first.
+//
+// workers can optionally be pinned one per core (linux only), so that cells
+// don't migrate between cores in the middle of a timed sort.
+//
+// with a single job there is no pool: the cells run one after another on the
+// calling thread, which keeps the main thread's stack (and ulimit -s) for the
+// deeply recursive engines.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __cellScheduler__
+#define __cellScheduler__
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+class cellScheduler {
+    public:
+    typedef std::function<std::string(size_t)>        cellTask;
+    typedef std::function<void(const std::string &)> cellSink;
+
+    cellScheduler(unsigned jobs = 1, bool pin = false) : jobs(jobs ? jobs : 1), pin(pin) {}
+
+    unsigned workers() const { return jobs; }
+
+    // run task(0) .. task(count - 1) on the pool, passing each result to sink
+    // in index order.  an exception thrown by a task is rethrown here.
+    void run(size_t count, cellTask task, cellSink sink) {
+        if (jobs == 1) {
+            if (pin) pinToCore(0);
+            for (size_t i = 0; i < count; i++) sink(task(i));
+            return;
+        }
+        results.assign(count, std::string());
+        ready.assign(count, false);
+        failure = nullptr;
+        next = 0;
+        std::vector<std::thread> pool;
+        for (unsigned w = 0; w < jobs && w < count; w++)
+            pool.emplace_back(&cellScheduler::work, this, w, count, std::ref(task));
+        for (size_t i = 0; i < count; i++) {
+            std::unique_lock<std::mutex> lock(guard);
+            finished.wait(lock, [&] { return ready[i] || failure; });
+            if (failure) break;
+            std::string result;
+            result.swap(results[i]);
+            lock.unlock();
+            sink(result);
+        }
+        for (auto &t : pool) t.join();
+        if (failure) std::rethrow_exception(failure);
+    }
+
+    private:
+    unsigned jobs;
+    bool pin;
+    std::atomic<size_t> next;
+    std::vector<std::string> results;
+    std::vector<bool> ready;
+    std::exception_ptr failure;
+    std::mutex guard;
+    std::condition_variable finished;
+
+    void work(unsigned worker, size_t count, cellTask &task) {
+        if (pin) pinToCore(worker);
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                std::string result = task(i);
+                std::lock_guard<std::mutex> lock(guard);
+                results[i].swap(result);
+                ready[i] = true;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(guard);
+                if (!failure) failure = std::current_exception();
+                next = count; // stop handing out cells
+            }
+            finished.notify_all();
+        }
+    }
+
+    // pin the calling thread to one core, wrapping around if there are more
+    // workers than cores.  silently does nothing where it isn't supported.
+    static void pinToCore(unsigned worker) {
+#ifdef __linux__
+        unsigned cores = std::thread::hardware_concurrency();
+        if (cores == 0) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(worker % cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)worker;
+#endif
+    }
+}; // class cellScheduler
+#endif
@@ -0,0 +1,290 @@
+//////////////////////////////////////////////////////////////////////////////////
+// externalSort.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// external merge sort for files of sortType keys which don't fit in memory.
+// the input is a raw binary file of keys in native byte order.
+//
+//     run formation  the input is memory mapped and cut into runs as large as
+//                    the memory budget.  each run is copied into one reusable
+//                    buffer, sorted with one of the in-memory engines, and
+//                    written out with large sequential writes.
+//     merging        runs are memory mapped and merged k at a time through a
+//                    loser tree, where k is limited by giving each run a
+//                    MERGEBLOCK share of the memory budget.  passes continue
+//                    until one run is left, the last one writing the output.
+//     verification   each run is hashed into a multiset hash of the input
+//                    while it's in memory, and the output is mapped and checked
+//                    in one streaming pass for order and against that hash
+//                    (see verification.hpp).  verify_ms includes both.
+//
+// the temporary run files are created next to the output and removed again.
+// errors are reported by throwing std::runtime_error.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __externalSort__
+#define __externalSort__
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "sortFunctor.hpp"
+#include "verification.hpp"
+
+#define MERGEBLOCK (1 << 20)   // bytes of the memory budget given to each merged run
+#define WRITEBLOCK (8 << 20)   // bytes buffered before each sequential write
+
+static std::runtime_error systemError(const std::string &what, const std::string &file) {
+    return std::runtime_error(what + " " + file + ": " + std::strerror(errno));
+}
+
+// a whole file mapped read-only, for one sequential pass
+class mappedKeys {
+    public:
+    mappedKeys(const std::string &file) : file(file) {
+        fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) throw systemError("can't open", file);
+        struct stat info;
+        if (fstat(fd, &info) < 0) { ::close(fd); throw systemError("can't stat", file); }
+        bytes = info.st_size;
+        if (bytes % sizeof(sortType)) {
+            ::close(fd);
+            throw std::runtime_error(file + " is not a whole number of keys.");
+        }
+        if (bytes == 0) return;
+        void *map = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) { ::close(fd); throw systemError("can't map", file); }
+        madvise(map, bytes, MADV_SEQUENTIAL);
+        keys = static_cast<const sortType *>(map);
+    }
+    ~mappedKeys() {
+        if (keys) munmap(const_cast<sortType *>(keys), bytes);
+        ::close(fd);
+    }
+    mappedKeys(const mappedKeys &) = delete;
+    mappedKeys &operator=(const mappedKeys &) = delete;
+
+    const sortType *begin() const { return keys; }
+    const sortType *end()   const { return keys + size(); }
+    indexType size()        const { return bytes / sizeof(sortType); }
+
+    private:
+    std::string file;
+    int fd;
+    size_t bytes = 0;
+    const sortType *keys = nullptr;
+};
+
+// buffers keys and writes them to a file in WRITEBLOCK sized writes
+class keyWriter {
+    public:
+    keyWriter(const std::string &file) : file(file) {
+        fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw systemError("can't create", file);
+        buffer.reserve(WRITEBLOCK / sizeof(sortType));
+    }
+    ~keyWriter() { if (fd >= 0) ::close(fd); }
+    keyWriter(const keyWriter &) = delete;
+    keyWriter &operator=(const keyWriter &) = delete;
+
+    void push(sortType key) {
+        buffer.push_back(key);
+        if (buffer.size() == buffer.capacity()) flush();
+    }
+    // large blocks bypass the buffer
+    void write(const sortType *keys, indexType n) {
+        flush();
+        writeAll(keys, n * sizeof(sortType));
+    }
+    void flush() {
+        writeAll(buffer.data(), buffer.size() * sizeof(sortType));
+        buffer.clear();
+    }
+    void close() {
+        flush();
+        if (::close(fd) < 0) throw systemError("can't write", file);
+        fd = -1;
+    }
+
+    private:
+    std::string file;
+    int fd;
+    std::vector<sortType> buffer;
+
+    void writeAll(const void *from, size_t bytes) {
+        const char *p = static_cast<const char *>(from);
+        while (bytes > 0) {
+            ssize_t written = ::write(fd, p, bytes);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw systemError("can't write", file);
+            }
+            p += written;
+            bytes -= written;
+        }
+    }
+};
+
+// tournament tree of losers over k sorted sources.  tree[0] holds the index of
+// the current winner and tree[1 .. k-1] the loser of the match at each node,
+// so replacing the winner replays only the log2(k) matches on its path.
+// an exhausted source loses to everything.
+class loserTree {
+    public:
+    struct source { const sortType *next, *end; };
+
+    loserTree(const std::vector<source> &sources) : sources(sources), k(sources.size()) {
+        const size_t empty = k;
+        tree.assign(k, empty);
+        for (size_t s = 0; s < k; s++) {
+            size_t winner = s;
+            size_t node = (s + k) / 2;
+            for (; node > 0; node /= 2) {
+                if (tree[node] == empty) { tree[node] = winner; break; }
+                if (beats(tree[node], winner)) std::swap(tree[node], winner);
+            }
+            if (node == 0) tree[0] = winner;
+        }
+    }
+
+    bool empty() const { return k == 0 || done(tree[0]); }
+    sortType top() const { return *sources[tree[0]].next; }
+
+    // drop the current winner and find the next one
+    void pop() {
+        size_t winner = tree[0];
+        sources[winner].next++;
+        for (size_t node = (winner + k) / 2; node > 0; node /= 2)
+            if (beats(tree[node], winner)) std::swap(tree[node], winner);
+        tree[0] = winner;
+    }
+
+    private:
+    std::vector<source> sources;
+    std::vector<size_t> tree;
+    size_t k;
+
+    bool done(size_t s) const { return sources[s].next == sources[s].end; }
+    bool beats(size_t a, size_t b) const {
+        if (done(a)) return false;
+        if (done(b)) return true;
+        return *sources[a].next < *sources[b].next || (*sources[a].next == *sources[b].next && a < b);
+    }
+};
+
+struct externalResult {
+    indexType keys = 0;
+    size_t runs = 0, fanIn = 0, passes = 0;
+    double runMs = 0, mergeMs = 0, verifyMs = 0;
+    bool verified = false;
+
+    double gbPerSecond() const {
+        double seconds = (runMs + mergeMs) / 1000;
+        return seconds > 0 ? keys * sizeof(sortType) / seconds / 1e9 : 0;
+    }
+
+    static std::string header() {
+        return "keys,engine,memory_bytes,runs,fan_in,merge_passes,run_ms,merge_ms,gb_per_s,verify_ms,verified";
+    }
+};
+
+class externalSorter {
+    public:
+    Sorts engine = Sorts::INTRO;
+    size_t memory = size_t(256) << 20;   // bytes of keys held in memory at once
+    unsigned threads = 1;
+
+    externalResult operator()(const std::string &inFile, const std::string &outFile) {
+        typedef std::chrono::duration<double, std::milli> Millis;
+        externalResult result;
+        std::vector<std::string> temporaries = {temporary(outFile), temporary(outFile)};
+        multisetHash inputHash;
+        Clock::duration hashing{};
+        try {
+            // run formation
+            auto start = Clock::now();
+            std::vector<indexType> bounds = {0};
+            {
+                mappedKeys input(inFile);
+                result.keys = input.size();
+                indexType runKeys = std::max<size_t>(memory / sizeof(sortType), 1);
+                std::vector<sortType> buffer(std::min(runKeys, result.keys));
+                bareSortFunctor sorter(0);
+                sorter.threads = threads;
+                // a single run is written straight to the output
+                bool single = result.keys <= runKeys;
+                keyWriter runs(single ? outFile : temporaries[0]);
+                for (indexType lo = 0; lo < result.keys; lo += runKeys) {
+                    indexType n = std::min(runKeys, result.keys - lo);
+                    std::copy(input.begin() + lo, input.begin() + lo + n, buffer.begin());
+                    auto hashed = Clock::now();
+                    inputHash.add(buffer.data(), n);
+                    hashing += Clock::now() - hashed;
+                    sorter.sortArray(engine, buffer.data(), n);
+                    runs.write(buffer.data(), n);
+                    bounds.push_back(lo + n);
+                }
+                runs.close();
+                result.runs = bounds.size() - 1;
+            }
+            auto formed = Clock::now();
+            result.runMs = Millis(formed - start - hashing).count();
+
+            // merge passes, ping-ponging between the two temporaries
+            result.fanIn = std::max<size_t>(memory / MERGEBLOCK, 2);
+            size_t current = 0;
+            while (bounds.size() > 2) {
+                mappedKeys runs(temporaries[current]);
+                bool last = bounds.size() - 1 <= result.fanIn;
+                keyWriter merged(last ? outFile : temporaries[1 - current]);
+                std::vector<indexType> next = {0};
+                for (size_t first = 0; first + 1 < bounds.size(); first += result.fanIn) {
+                    size_t stop = std::min(first + result.fanIn, bounds.size() - 1);
+                    std::vector<loserTree::source> sources;
+                    for (size_t r = first; r < stop; r++)
+                        sources.push_back({runs.begin() + bounds[r], runs.begin() + bounds[r + 1]});
+                    loserTree tree(sources);
+                    for (; !tree.empty(); tree.pop()) merged.push(tree.top());
+                    next.push_back(bounds[stop]);
+                }
+                merged.close();
+                bounds.swap(next);
+                current = 1 - current;
+                result.passes++;
+            }
+            result.mergeMs = Millis(Clock::now() - formed).count();
+        } catch (...) {
+            for (auto &t : temporaries) std::remove(t.c_str());
+            throw;
+        }
+        for (auto &t : temporaries) std::remove(t.c_str());
+
+        // streaming verification
+        auto start = Clock::now();
+        {
+            mappedKeys output(outFile);
+            streamingVerifier verifier;
+            verifier.add(output.begin(), output.size());
+            result.verified = verifier.sorted() && verifier.hash == inputHash;
+        }
+        result.verifyMs = Millis(Clock::now() - start + hashing).count();
+        return result;
+    }
+
+    private:
+    // a fresh temporary file name next to the output
+    static std::string temporary(const std::string &outFile) {
+        std::string name = outFile + ".runXXXXXX";
+        int fd = mkstemp(&name[0]);
+        if (fd < 0) throw systemError("can't create temporary for", outFile);
+        ::close(fd);
+        return name;
+    }
+}; // class externalSorter
+#endif
@@ -0,0 +1,268 @@
+//////////////////////////////////////////////////////////////////////////////////
+// inputGenerator.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// the initial orders the sorts are measured on, and the generator for them.
+//
+// every input is reproducible from one 64-bit seed: the seed for an input is
+// mixed from (seed, N, order), and the input is cut into GENBLOCK sized blocks
+// which each get their own xoshiro256** stream mixed from that and the block
+// number.  blocks are generated on one thread per core, whatever --threads the
+// engines get, but since the streams belong to the blocks and not to the
+// threads, the result doesn't depend on how many threads there were.
+//
+//     forward / reverse      1..N ascending / descending
+//     almost forward/reverse the same with ALMOST percent of random swaps,
+//                            each block swapping within itself
+//     shuffled               a uniform random permutation of 1..N: keys are
+//                            scattered to random buckets, then each bucket is
+//                            Fisher-Yates shuffled on its own
+//     zipf                   keys in 1..N, approximately Zipf(1) distributed by
+//                            inverting the continuous density (key = (N+1)^u)
+//     few unique             FEWKEYS distinct keys spread across 1..N
+//     organ pipe             1..N/2 ascending then descending again
+//     sawtooth               SAWTEETH ascending teeth
+//     sorted runs            a permutation of 1..N made of SORTEDRUNCOUNT ascending
+//                            runs, run r holding the keys congruent to r
+//     all equal              every key is 1
+//
+// xoshiro256** comes from David Blackman and Sebastiano Vigna:
+// http://prng.di.unimi.it/xoshiro256starstar.c
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __inputGenerator__
+#define __inputGenerator__
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ALMOST 10
+#define GENBLOCK (1 << 16) // keys per independently seeded block of an input
+#define SHUFFLEBUCKETS 256 // most buckets the parallel shuffle scatters into
+#define FEWKEYS 16         // distinct keys in the few unique order
+#define SAWTEETH 16        // teeth in the sawtooth order
+#define SORTEDRUNCOUNT 16  // runs in the sorted runs order
+typedef size_t sortType;
+typedef size_t indexType;
+
+enum class Orders : int { FORWARD, ALMOSTFORWARD, UNIFORM, ALMOSTREVERSE, REVERSE,
+                          ZIPF, FEWUNIQUE, ORGANPIPE, SAWTOOTH, SORTEDRUNS, ALLEQUAL};
+const std::array<Orders, 11> allOrders = {Orders::FORWARD, Orders::ALMOSTFORWARD,
+                                          Orders::UNIFORM, Orders::ALMOSTREVERSE, Orders::REVERSE,
+                                          Orders::ZIPF, Orders::FEWUNIQUE, Orders::ORGANPIPE,
+                                          Orders::SAWTOOTH, Orders::SORTEDRUNS, Orders::ALLEQUAL};
+const std::array<std::string, 11> orderNames = {"forward_sorted", "almost_forward",
+                                                "shuffled_randm", "almost_reverse", "reverse_sorted",
+                                                "zipf", "few_unique", "organ_pipe",
+                                                "sawtooth", "sorted_runs", "all_equal"};
+static constexpr int cast(Orders a) { return static_cast<int>(a); }
+
+static inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// mix a seed with a stream number into an independent seed
+static inline uint64_t mixSeed(uint64_t seed, uint64_t stream) {
+    return splitmix64(seed ^ splitmix64(stream));
+}
+
+// xoshiro256**, usable anywhere a standard random engine is
+struct xoshiro256 {
+    typedef uint64_t result_type;
+    uint64_t s[4];
+
+    explicit xoshiro256(uint64_t seed = 0) {
+        for (uint64_t &word : s) word = seed = splitmix64(seed);
+    }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+    result_type operator()() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+    // uniform in [0, n)
+    uint64_t below(uint64_t n) { return n ? (*this)() % n : 0; }
+    // uniform in [0, 1)
+    double unit() { return ((*this)() >> 11) / 9007199254740992.0; }
+
+    private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// a fresh seed from the system's entropy source
+static inline uint64_t randomSeed() {
+    std::random_device source;
+    return (uint64_t(source()) << 32) ^ source();
+}
+
+// run f(0) .. f(count - 1) on up to `threads` threads
+static void parallelFor(indexType count, unsigned threads, std::function<void(indexType)> f) {
+    threads = std::max(1u, std::min<unsigned>(threads, count));
+    if (threads == 1) {
+        for (indexType i = 0; i < count; i++) f(i);
+        return;
+    }
+    std::atomic<indexType> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++)
+        pool.emplace_back([&] { for (indexType i = next++; i < count; i = next++) f(i); });
+    for (auto &p : pool) p.join();
+}
+
+// uniform random permutation of arr, in parallel: every key goes to a random
+// bucket, the buckets are laid out in order, then each is shuffled on its own
+static void parallelShuffle(sortType *arr, indexType N, uint64_t seed, unsigned threads) {
+    const indexType blocks = (N + GENBLOCK - 1) / GENBLOCK;
+    const indexType B = std::min<indexType>(blocks, SHUFFLEBUCKETS);
+    if (B <= 1) {
+        xoshiro256 rng(mixSeed(seed, 0));
+        for (indexType i = N; i > 1; i--) std::swap(arr[i - 1], arr[rng.below(i)]);
+        return;
+    }
+    std::vector<uint8_t> bucketOf(N);
+    std::vector<indexType> counts(blocks * B, 0);
+    parallelFor(blocks, threads, [&](indexType b) {
+        xoshiro256 rng(mixSeed(seed, b));
+        for (indexType i = b * GENBLOCK; i < std::min(N, (b + 1) * GENBLOCK); i++) {
+            bucketOf[i] = rng.below(B);
+            counts[b * B + bucketOf[i]]++;
+        }
+    });
+    // bucket-major offsets, so every block writes its own slice of each bucket
+    std::vector<indexType> offset(blocks * B), start(B + 1);
+    indexType sum = 0;
+    for (indexType k = 0; k < B; k++) {
+        start[k] = sum;
+        for (indexType b = 0; b < blocks; b++) { offset[b * B + k] = sum; sum += counts[b * B + k]; }
+    }
+    start[B] = N;
+    std::vector<sortType> scattered(N);
+    parallelFor(blocks, threads, [&](indexType b) {
+        for (indexType i = b * GENBLOCK; i < std::min(N, (b + 1) * GENBLOCK); i++)
+            scattered[offset[b * B + bucketOf[i]]++] = arr[i];
+    });
+    parallelFor(B, threads, [&](indexType k) {
+        xoshiro256 rng(mixSeed(seed, blocks + k));
+        sortType *bucket = scattered.data() + start[k];
+        for (indexType i = start[k + 1] - start[k]; i > 1; i--) std::swap(bucket[i - 1], bucket[rng.below(i)]);
+        std::copy(bucket, scattered.data() + start[k + 1], arr + start[k]);
+    });
+}
+
+// fill arr with N keys in the given order, reproducibly from seed
+static void generateInput(sortType *arr, indexType N, Orders order, uint64_t seed, unsigned threads = 1) {
+    if (N == 0) return;
+    const indexType blocks = (N + GENBLOCK - 1) / GENBLOCK;
+    // run f(i, rng) for every index, each block with its own stream
+    auto fill = [&](std::function<sortType(indexType, xoshiro256 &)> f) {
+        parallelFor(blocks, threads, [&](indexType b) {
+            xoshiro256 rng(mixSeed(seed, b));
+            for (indexType i = b * GENBLOCK; i < std::min(N, (b + 1) * GENBLOCK); i++) arr[i] = f(i, rng);
+        });
+    };
+    // ALMOST percent of each block's keys swapped with others in the block
+    auto perturb = [&]() {
+        parallelFor(blocks, threads, [&](indexType b) {
+            xoshiro256 rng(mixSeed(seed, blocks + b));
+            indexType lo = b * GENBLOCK, n = std::min(N, lo + GENBLOCK) - lo;
+            for (indexType s = n / ALMOST + 1; s > 0; s--)
+                std::swap(arr[lo + rng.below(n)], arr[lo + rng.below(n)]);
+        });
+    };
+    switch (order) {
+        case Orders::FORWARD:
+            fill([](indexType i, xoshiro256 &) { return i + 1; });
+            break;
+        case Orders::ALMOSTFORWARD:
+            fill([](indexType i, xoshiro256 &) { return i + 1; });
+            perturb();
+            break;
+        case Orders::REVERSE:
+            fill([=](indexType i, xoshiro256 &) { return N - i; });
+            break;
+        case Orders::ALMOSTREVERSE:
+            fill([=](indexType i, xoshiro256 &) { return N - i; });
+            perturb();
+            break;
+        case Orders::UNIFORM:
+            fill([=](indexType i, xoshiro256 &) { return N - i; });
+            parallelShuffle(arr, N, mixSeed(seed, 2 * blocks), threads);
+            break;
+        case Orders::ZIPF: {
+            const double logRange = std::log(double(N) + 1);
+            fill([=](indexType, xoshiro256 &rng) {
+                return std::min<sortType>(N, sortType(std::exp(rng.unit() * logRange)));
+            });
+        } break;
+        case Orders::FEWUNIQUE: {
+            const sortType spacing = std::max<sortType>(N / FEWKEYS, 1);
+            fill([=](indexType, xoshiro256 &rng) { return rng.below(FEWKEYS) * spacing + 1; });
+        } break;
+        case Orders::ORGANPIPE:
+            fill([=](indexType i, xoshiro256 &) { return i < (N + 1) / 2 ? i + 1 : N - i; });
+            break;
+        case Orders::SAWTOOTH: {
+            const indexType tooth = std::max<indexType>((N + SAWTEETH - 1) / SAWTEETH, 1);
+            fill([=](indexType i, xoshiro256 &) { return i % tooth + 1; });
+        } break;
+        case Orders::SORTEDRUNS: {
+            // run r holds r+1, r+1+k, r+1+2k ... so the runs interleave
+            const indexType k = std::min<indexType>(SORTEDRUNCOUNT, N);
+            std::vector<indexType> start(k + 1, 0);
+            for (indexType r = 0; r < k; r++) start[r + 1] = start[r] + (N - r + k - 1) / k;
+            parallelFor(k, threads, [&](indexType r) {
+                for (indexType j = 0; start[r] + j < start[r + 1]; j++) arr[start[r] + j] = j * k + r + 1;
+            });
+        } break;
+        case Orders::ALLEQUAL:
+            fill([](indexType, xoshiro256 &) { return 1; });
+            break;
+    }
+} // void generateInput
+
+// the input sets for one size, shared read-only by every copy of a functor.
+// each order is generated the first time it is asked for.
+class inputSets {
+    public:
+    const indexType N;
+    const uint64_t seed;
+
+    inputSets(indexType N, uint64_t seed) : N(N), seed(seed) {}
+
+    // the seed one order of this size is generated from
+    uint64_t orderSeed(Orders o) const { return mixSeed(mixSeed(seed, N), cast(o)); }
+
+    // generation isn't timed, so it uses every core
+    const sortType *keys(Orders o) {
+        std::call_once(generated[cast(o)], [&] {
+            input[cast(o)].reset(new sortType[N]);
+            unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+            generateInput(input[cast(o)].get(), N, o, orderSeed(o), cores);
+        });
+        return input[cast(o)].get();
+    }
+
+    private:
+    std::once_flag generated[allOrders.size()];
+    std::unique_ptr<sortType[]> input[allOrders.size()];
+};
+#endif
@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////////////////
+// libraryAdapters.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// wrappers which let the standard library's sorts be counted like the engines:
+//
+//     countingLess      a comparator that counts each comparison and compares
+//                       keys through elementKey, so it also works on index
+//                       elements and on the references below
+//     countingIterator  a random access iterator over an array of elements
+//                       whose reference is a countedRef proxy.  the proxy
+//                       counts the bytes moved when an element is copied out
+//                       of it or into it, and an exchange when two of them are
+//                       swapped.
+//     keyLess           the same comparison without any counting, for the
+//                       timed runs on the bare twin
+//
+// the library algorithms only move elements through their iterators' references
+// and iter_swap, so the counts cover everything they do to the array.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __libraryAdapters__
+#define __libraryAdapters__
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include "records.hpp"
+
+typedef size_t countType;
+
+// what the proxies count into: the functor's own counters
+struct moveCounters {
+    countType *exchanges;
+    countType *bytesMoved;
+};
+
+template <class Element>
+struct countedRef {
+    Element *element;
+    moveCounters counters;
+
+    operator Element() const {
+        *counters.bytesMoved += sizeof(Element);
+        return *element;
+    }
+    countedRef &operator=(const Element &from) {
+        *counters.bytesMoved += sizeof(Element);
+        *element = from;
+        return *this;
+    }
+    countedRef &operator=(const countedRef &from) {
+        *counters.bytesMoved += sizeof(Element);
+        *element = *from.element;
+        return *this;
+    }
+    // the library swaps through references it gets by value
+    friend void swap(countedRef a, countedRef b) {
+        ++*a.counters.exchanges;
+        *a.counters.bytesMoved += 2 * sizeof(Element);
+        std::swap(*a.element, *b.element);
+    }
+};
+
+template <class Element>
+class countingIterator {
+    public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef Element                         value_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef Element                        *pointer;
+    typedef countedRef<Element>             reference;
+
+    countingIterator() : at(nullptr), counters{nullptr, nullptr} {}
+    countingIterator(Element *at, moveCounters counters) : at(at), counters(counters) {}
+
+    reference operator*() const { return {at, counters}; }
+    reference operator[](difference_type n) const { return {at + n, counters}; }
+
+    countingIterator &operator++() { ++at; return *this; }
+    countingIterator &operator--() { --at; return *this; }
+    countingIterator operator++(int) { countingIterator was = *this; ++at; return was; }
+    countingIterator operator--(int) { countingIterator was = *this; --at; return was; }
+    countingIterator &operator+=(difference_type n) { at += n; return *this; }
+    countingIterator &operator-=(difference_type n) { at -= n; return *this; }
+    countingIterator operator+(difference_type n) const { return countingIterator(at + n, counters); }
+    countingIterator operator-(difference_type n) const { return countingIterator(at - n, counters); }
+    friend countingIterator operator+(difference_type n, const countingIterator &i) { return i + n; }
+    difference_type operator-(const countingIterator &other) const { return at - other.at; }
+
+    bool operator==(const countingIterator &other) const { return at == other.at; }
+    bool operator!=(const countingIterator &other) const { return at != other.at; }
+    bool operator<(const countingIterator &other)  const { return at < other.at; }
+    bool operator>(const countingIterator &other)  const { return at > other.at; }
+    bool operator<=(const countingIterator &other) const { return at <= other.at; }
+    bool operator>=(const countingIterator &other) const { return at >= other.at; }
+
+    private:
+    Element *at;
+    moveCounters counters;
+};
+
+// the key of an element, or of the element behind a reference, without
+// counting a move
+template <class Element>
+static inline sortType adapterKey(const Element &e, const keyTable &table) { return elementKey(e, table); }
+template <class Element>
+static inline sortType adapterKey(const countedRef<Element> &r, const keyTable &table) {
+    return elementKey(*r.element, table);
+}
+
+template <class Element>
+struct countingLess {
+    countType *comparisons;
+    const keyTable *table;
+    template <class A, class B>
+    bool operator()(const A &a, const B &b) const {
+        ++*comparisons;
+        return adapterKey<Element>(a, *table) < adapterKey<Element>(b, *table);
+    }
+};
+
+template <class Element>
+struct keyLess {
+    const keyTable *table;
+    bool operator()(const Element &a, const Element &b) const {
+        return elementKey(a, *table) < elementKey(b, *table);
+    }
+};
+#endif
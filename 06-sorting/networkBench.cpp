@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////////////
+// networkBench.cpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// microbenchmark for the leaf sorts: for each network block size it sorts the
+// same set of random blocks with the vector network, the scalar network and a
+// plain insertion sort, and prints CSV of nanoseconds per block.
+//
+// to compile: g++ -std=c++11 -O2 -march=native networkBench.cpp -o networkBench
+//     to run: ./networkBench [blocks]
+//
+//////////////////////////////////////////////////////////////////////////////////
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "sortingNetwork.hpp"
+
+typedef std::chrono::high_resolution_clock        Clock;
+typedef std::chrono::duration<double, std::nano>  Duration;
+
+void insertionSort(uint64_t *a, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        uint64_t key = a[i];
+        size_t j = i;
+        for (; j > 0 && key < a[j - 1]; j--) a[j] = a[j - 1];
+        a[j] = key;
+    }
+}
+
+// time one leaf sort over every block of a fresh copy of the input,
+// returning nanoseconds per block.  a bad sort is reported, not timed.
+double timeLeaf(const std::vector<uint64_t> &input, size_t block,
+                std::function<void(uint64_t *)> leaf) {
+    std::vector<uint64_t> work(input);
+    size_t blocks = work.size() / block;
+    auto start = Clock::now();
+    for (size_t b = 0; b < blocks; b++) leaf(work.data() + b * block);
+    Duration elapsed = Clock::now() - start;
+    for (size_t b = 0; b < blocks; b++)
+        if (!std::is_sorted(work.begin() + b * block, work.begin() + (b + 1) * block)) {
+            std::cerr << "error: block of " << block << " not sorted.\n";
+            break;
+        }
+    return elapsed.count() / blocks;
+}
+
+int main(int argc, char *argv[]) {
+    size_t blocks = argc > 1 ? atol(argv[1]) : 1 << 16;
+    std::mt19937_64 rd(2016);
+    std::cout << "block,leaf,ns_per_block\n";
+    for (size_t block : {8, 16, 32}) {
+        std::vector<uint64_t> input(blocks * block);
+        for (uint64_t &key : input) key = rd();
+        std::function<void(uint64_t *)> vector, scalar;
+        switch (block) {
+            case 8:  vector = bitonicSort<8>;  scalar = bitonicSortScalar<8>;  break;
+            case 16: vector = bitonicSort<16>; scalar = bitonicSortScalar<16>; break;
+            default: vector = bitonicSort<32>; scalar = bitonicSortScalar<32>; break;
+        }
+        std::cout << block << ",network_" NETWORK_ISA "," << timeLeaf(input, block, vector) << "\n"
+                  << block << ",network_scalar,"      << timeLeaf(input, block, scalar) << "\n"
+                  << block << ",insertion,"
+                  << timeLeaf(input, block, [=](uint64_t *a) { insertionSort(a, block); }) << "\n";
+    }
+}
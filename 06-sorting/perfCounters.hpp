@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////////
+// perfCounters.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// hardware performance counters around a sort, read through linux's
+// perf_event_open: cycles, instructions, L1 data cache read misses, last level
+// cache misses and branch mispredictions.  the counters follow the thread that
+// opened them and any threads it starts, and only count user space, so they
+// work with the default perf_event_paranoid setting.
+//
+// each counter is opened on its own, so a machine (or VM) which only has some
+// of them still reports those.  a counter which couldn't be opened, or any
+// counter on a system without perf_event_open, is written to the CSV as a
+// blank column rather than failing the run.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __perfCounters__
+#define __perfCounters__
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sstream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class Counters : int { CYCLES, INSTRUCTIONS, L1MISSES, LLCMISSES, BRANCHMISSES };
+const std::array<std::string, 5> counterNames = {"cycles", "instructions", "l1d_misses", "llc_misses",
+                                                 "branch_misses"};
+
+class perfCounters {
+    public:
+    perfCounters() { fds.fill(-1); values.fill(0); }
+    ~perfCounters() { close(); }
+    perfCounters(const perfCounters &) = delete;
+    perfCounters &operator=(const perfCounters &) = delete;
+
+    // counters are opened for the calling thread, so open them from the thread
+    // that is going to run the sort
+    void open() {
+        if (opened) return;
+        opened = true;
+#ifdef __linux__
+        const uint64_t l1Read = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        fds[0] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[1] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[2] = openCounter(PERF_TYPE_HW_CACHE, l1Read);
+        fds[3] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[4] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+    }
+
+    void start() {
+        open();
+#ifdef __linux__
+        for (int fd : fds) if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        for (int fd : fds) if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int fd : fds) if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (size_t i = 0; i < fds.size(); i++) {
+            uint64_t value = 0;
+            if (fds[i] >= 0 && ::read(fds[i], &value, sizeof(value)) == sizeof(value)) values[i] = value;
+            else values[i] = 0;
+        }
+#endif
+    }
+
+    bool available(Counters c) const { return fds[static_cast<int>(c)] >= 0; }
+    uint64_t value(Counters c) const { return values[static_cast<int>(c)]; }
+
+    // the counters as CSV columns, each led by the delimiter, blank if unavailable
+    std::string csv(char delimiter) const {
+        std::ostringstream buffer;
+        for (size_t i = 0; i < fds.size(); i++) {
+            buffer << delimiter;
+            if (fds[i] >= 0) buffer << values[i];
+        }
+        return buffer.str();
+    }
+
+    // the matching CSV column names
+    static std::string header(char delimiter) {
+        std::string names;
+        for (const std::string &name : counterNames) names += delimiter + name;
+        return names;
+    }
+
+    private:
+    std::array<int, 5> fds;
+    std::array<uint64_t, 5> values;
+    bool opened = false;
+
+    void close() {
+#ifdef __linux__
+        for (int &fd : fds) if (fd >= 0) { ::close(fd); fd = -1; }
+#endif
+    }
+
+#ifdef __linux__
+    static int openCounter(uint32_t type, uint64_t config) {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.disabled       = 1;
+        attr.inherit        = 1;   // count threads started by the parallel engines
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+}; // class perfCounters
+#endif
@@ -0,0 +1,63 @@
+//////////////////////////////////////////////////////////////////////////////////
+// records.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// the element types the sort engines can be instantiated on, besides bare
+// sortType keys:
+//
+//     record<P>     a sortType key followed by P bytes of payload, so moving a
+//                   record costs what moving a real row would.  the payload is
+//                   filled from the key, which lets verification check that
+//                   every record arrived with its own payload.
+//     recordIndex   a 32-bit index into an array of records, for the indirect
+//                   (argsort) mode.  its key is looked up through a keyTable.
+//
+// the engines only touch an element's key through elementKey, and build and
+// check elements through makeElement and intact.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __records__
+#define __records__
+#include <cstddef>
+#include <cstdint>
+#include "inputGenerator.hpp"
+
+template <size_t Payload>
+struct record {
+    static_assert(Payload % sizeof(sortType) == 0, "the payload is filled a key at a time");
+    sortType key;
+    sortType payload[Payload / sizeof(sortType)];
+};
+
+struct recordIndex { uint32_t index; };
+
+// where an indirect sort finds the key of record i: at base + i * stride
+struct keyTable {
+    const char *base = nullptr;
+    size_t stride = 0;
+};
+
+static inline sortType elementKey(sortType key, const keyTable &) { return key; }
+template <size_t Payload>
+static inline sortType elementKey(const record<Payload> &r, const keyTable &) { return r.key; }
+static inline sortType elementKey(recordIndex r, const keyTable &table) {
+    return *reinterpret_cast<const sortType *>(table.base + r.index * table.stride);
+}
+
+// the bytes of a record's payload, as a function of its key
+static inline sortType payloadWord(sortType key) { return splitmix64(key); }
+
+static inline void makeElement(sortType &element, sortType key) { element = key; }
+template <size_t Payload>
+static inline void makeElement(record<Payload> &r, sortType key) {
+    r.key = key;
+    for (sortType &word : r.payload) word = payloadWord(key);
+}
+
+static inline bool intact(sortType) { return true; }
+template <size_t Payload>
+static inline bool intact(const record<Payload> &r) {
+    for (sortType word : r.payload) if (word != payloadWord(r.key)) return false;
+    return true;
+}
+#endif
@@ -8,10 +8,245 @@
 // CSV data based time elapsed, exchanges, and comparisons of each sort.
 // if no filename is passed, it outputs the data to console
 //
+// to compile: g++ -std=c++11 -O2 -march=native -pthread sort.cpp -o sortstats
+//             (-march=native lets the sorting network leaves use AVX2 or SSE4.2)
+//             with -std=c++17 (and -ltbb for libstdc++) the sweep also runs
+//             std::sort with the par_unseq execution policy
+//
+// options may appear anywhere on the command line:
+//     --jobs=N   run the cells of the sweep on N worker threads.  each cell gets
+//                its own copy of the working buffers; the CSV rows still come
+//                out in the same order as a serial run.  with one job (the
+//                default) the cells run on the main thread instead.
+//     --pin      pin each worker thread to its own core (linux only)
+//     --threads=N  threads used inside the parallel engines (samplesort).  this
+//                is written to the threads column, so runs with different
+//                counts can be combined into speedup curves.
+//     --warmup=N untimed runs of each cell before it is timed
+//     --reps=K   timed runs of each cell, each on a fresh copy of the input.
+//                ms_elapsed is the median, with min/median/p95/stddev columns.
+//     --touch    before every run, sweep the caches and re-touch the buffers,
+//                so each repetition starts from the same state
+//     --seed=S   generate the inputs from seed S.  without it a random seed is
+//                drawn; either way it is written to the seed column, and
+//                running again with --seed reproduces every input exactly.
+//     --payload=P sort records of a key and P bytes of payload (16, 64 or 256)
+//                instead of bare keys.  record_bytes is the size of a record.
+//     --indirect sort an array of 32-bit indexes by key, then move the
+//                records into place once at the end (argsort)
+//     --k=K1,K2,... run the selection engines (introselect, floyd_rivest,
+//                heap_topk) once for each k, selecting the k smallest keys.
+//                without it they select the median.  the k column is k for
+//                the selection engines and N for the full sorts.
+//     --budget=MS give each cell MS milliseconds.  a cell which runs past it is
+//                aborted (except the std_ sorts, which can't be stopped), and
+//                one the sizes already measured say can't make it isn't
+//                started.  either way ms_elapsed is extrapolated from
+//                the best of an n, n log n or n^2 fit to the smaller sizes of
+//                the same sort and order, and the row has extrapolated = 1
+//                and the fit in the model column (see cellBudget.hpp).  with
+//                fewer than two sizes to fit, ms_elapsed is left empty and the
+//                model is over_budget.
+//     --hugepages back the working buffers with 2 MiB pages, explicit ones if
+//                any are reserved, otherwise transparent huge pages
+//     --numa     place each worker's buffers on its own NUMA node (use with
+//                --pin).  either way the buffers are pooled and pre-faulted
+//                (see bufferPool.hpp), and page_faults counts the faults taken
+//                during the timed run.
+//     --strings  sweep the string engines (see stringSort.hpp) over generated
+//                name-like keys instead, with their own CSV columns
+//
+// external sort mode, which replaces the sweep:
+//     sortstats --external=keys.bin [--sorted=out.bin] [--memory=MiB] [--engine=name]
+//     sorts a binary file of keys bigger than memory (see externalSort.hpp) and
+//     prints one CSV row with the runs, merge passes and GB/s.  the sorted keys
+//     go to keys.bin.sorted unless --sorted is given; runs are sorted with
+//     introsort unless --engine names another sort.
+//
 //////////////////////////////////////////////////////////////////////////////////
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "sortFunctor.hpp"
+#include "cellScheduler.hpp"
+#include "externalSort.hpp"
+#include "stringSort.hpp"
+
+// all of the cells for one dataset size share one set of generated inputs,
+// built by whichever worker gets there first and released after the last cell
+template <class Functor>
+struct sizeGroup {
+    indexType size;
+    std::once_flag built;
+    std::shared_ptr<Functor> prototype;
+    std::atomic<size_t> remaining;
+    sizeGroup(indexType size, size_t cells) : size(size), remaining(cells) {}
+};
+
+// one sort of the sweep: a full sort, or a selection engine with its k
+struct sweepSort {
+    Sorts sort;
+    indexType k;
+};
+
+// the settings every cell's functor is given
+struct sweepSettings {
+    unsigned jobs, threads, warmups, reps;
+    unsigned budget;            // milliseconds per cell, 0 for no budget
+    bool pin, touch, indirect, verbose;
+    uint64_t seed;
+    std::vector<indexType> ks;  // the selection engines' k, 0 for the median
+};
+
+// runs every size x sort x order cell with functors sorting Functor's
+// element type, writing the rows to output in that order
+template <class Functor>
+void sweep(indexType starting, indexType ending, indexType step, const sweepSettings &settings,
+           std::ostream &output) {
+    std::vector<sweepSort> sorts;
+    for (Sorts s : allSorts) {
+        if (!isAvailable(s)) continue;
+        if (isSelection(s)) for (indexType k : settings.ks) sorts.push_back({s, k});
+        else sorts.push_back({s, 0});
+    }
+    const size_t cellsPerSize = sorts.size() * allOrders.size();
+    std::vector<std::unique_ptr<sizeGroup<Functor>>> groups;
+    for (indexType i = starting; i <= ending; i += step)
+        groups.emplace_back(new sizeGroup<Functor>(i, cellsPerSize));
+    budgetHistory history;
+
+    // cells are numbered in the same size -> sort -> order nesting as the
+    // serial loop, which is the order the scheduler writes them in
+    auto runCell = [&](size_t cell) -> std::string {
+        sizeGroup<Functor> &group = *groups[cell / cellsPerSize];
+        const sweepSort &s = sorts[(cell / allOrders.size()) % sorts.size()];
+        Orders o = allOrders[cell % allOrders.size()];
+        std::call_once(group.built, [&] {
+            group.prototype = std::make_shared<Functor>(group.size, settings.verbose, settings.seed);
+            group.prototype->threads     = settings.threads;
+            group.prototype->warmups     = settings.warmups;
+            group.prototype->repetitions = settings.reps;
+            group.prototype->touch       = settings.touch;
+            group.prototype->indirect    = settings.indirect;
+        });
+        std::string result;
+        {
+            Functor sort(*group.prototype, settings.verbose);
+            sort.rank = s.k;
+            result = budgetedCell(sort, s, o, settings, history);
+        }
+        if (--group.remaining == 0) group.prototype.reset();
+        return result;
+    };
+    cellScheduler scheduler(settings.jobs, settings.pin);
+    scheduler.run(groups.size() * cellsPerSize, runCell,
+                  [&](const std::string &row) { output << row << std::endl; });
+}
+
+// runs one cell within the settings' budget, extrapolating its time from the
+// smaller sizes of its series if it can't be measured in time
+template <class Functor>
+std::string budgetedCell(Functor &sort, const sweepSort &s, Orders o, const sweepSettings &settings,
+                         budgetHistory &history) {
+    if (settings.budget == 0) return sort(s.sort, o);
+    const std::string series = sortNames[cast(s.sort)] + "/" + std::to_string(s.k) + "/" + orderNames[cast(o)];
+    const Clock::duration budget = std::chrono::milliseconds(settings.budget);
+    complexityModel model = history.model(series, sort.N);
+    // the counted run, the warmups and the repetitions all come out of the budget
+    const double runs = 1 + settings.warmups + settings.reps;
+    if (model.fitted() && model.predict(sort.N) * runs > budget.count())
+        return sort.extrapolatedRow(s.sort, o, model.predict(sort.N), model.name);
+    // with nothing to fit, nothing is known of a cell whose series already
+    // overran, so its ms_elapsed is left empty
+    if (!model.fitted() && history.overranBelow(series, sort.N))
+        return sort.extrapolatedRow(s.sort, o, -1, "over_budget");
+    sort.budgeted = true;
+    sort.deadline = Clock::now() + budget;
+    try {
+        std::string row = sort(s.sort, o);
+        history.add(series, sort.N, sort.elapsed);
+        return row;
+    } catch (overBudget &) {
+        if (settings.verbose) std::cout << "over budget.\n";
+        // a lower bound in the same measure as ms_elapsed: the runs it is the
+        // median of hadn't all finished in the time since they began, so each
+        // takes at least that time over their number.  aborted in the counted
+        // run, nothing is known of them.
+        double atLeast = 0;
+        if (sort.timedRuns > 0) atLeast = (Clock::now() - sort.timedStart).count() / double(sort.timedRuns);
+        history.overran(series, sort.N, atLeast);
+        model = history.model(series, sort.N);
+        if (!model.fitted()) return sort.extrapolatedRow(s.sort, o, -1, "over_budget");
+        return sort.extrapolatedRow(s.sort, o, model.predict(sort.N), model.name);
+    }
+}
+
+// the --strings sweep: every size x string sort x order cell, scheduled the
+// same way as the sweep of the key sorts
+static void stringSweep(indexType starting, indexType ending, indexType step, const sweepSettings &settings,
+                        std::ostream &output) {
+    const size_t cellsPerSize = allStringSorts.size() * stringOrders.size();
+    std::vector<std::unique_ptr<sizeGroup<stringSorter>>> groups;
+    for (indexType i = starting; i <= ending; i += step)
+        groups.emplace_back(new sizeGroup<stringSorter>(i, cellsPerSize));
+
+    auto runCell = [&](size_t cell) -> std::string {
+        sizeGroup<stringSorter> &group = *groups[cell / cellsPerSize];
+        StringSorts s = allStringSorts[(cell / stringOrders.size()) % allStringSorts.size()];
+        Orders o = stringOrders[cell % stringOrders.size()];
+        std::call_once(group.built, [&] {
+            group.prototype = std::make_shared<stringSorter>(group.size, settings.verbose, settings.seed);
+            group.prototype->warmups     = settings.warmups;
+            group.prototype->repetitions = settings.reps;
+        });
+        std::string result;
+        {
+            stringSorter sort(*group.prototype, settings.verbose);
+            result = sort(s, o);
+        }
+        if (--group.remaining == 0) group.prototype.reset();
+        return result;
+    };
+    cellScheduler scheduler(settings.jobs, settings.pin);
+    scheduler.run(groups.size() * cellsPerSize, runCell,
+                  [&](const std::string &row) { output << row << std::endl; });
+}
+
+// matches --name=value, parsing value into target
+static bool option(const std::string &arg, const std::string &name, unsigned &target) {
+    std::string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    target = atol(arg.c_str() + prefix.size());
+    return true;
+}
+
+static bool option(const std::string &arg, const std::string &name, uint64_t &target) {
+    std::string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    target = strtoull(arg.c_str() + prefix.size(), nullptr, 10);
+    return true;
+}
+
+static bool option(const std::string &arg, const std::string &name, std::string &target) {
+    std::string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    target = arg.substr(prefix.size());
+    return true;
+}
+
+// a comma separated list of numbers
+static bool option(const std::string &arg, const std::string &name, std::vector<indexType> &target) {
+    std::string list;
+    if (!option(arg, name, list)) return false;
+    target.clear();
+    std::istringstream items(list);
+    for (std::string item; std::getline(items, item, ',');) target.push_back(strtoull(item.c_str(), nullptr, 10));
+    return true;
+}
 
 int main(int argc, char *argv[]) {
     // parameter list: <start> <end> <step> <output>
@@ -21,8 +256,71 @@ int main(int argc, char *argv[]) {
     // output    - file to send results to
     
     indexType starting, ending, count, step;
+    unsigned jobs = 1, threads = 1, warmups = 0, reps = 1, memory = 256, payload = 0, budget = 0;
+    bool pin = false, touch = false, indirect = false, strings = false, hugePages = false, numaLocal = false;
+    std::string external, sorted, engine = sortNames[cast(Sorts::INTRO)];
+    uint64_t seed = randomSeed();
+    std::vector<indexType> ks = {0};
+    std::vector<char *> args;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        if      (option(arg, "jobs", jobs))       continue;
+        else if (option(arg, "threads", threads)) continue;
+        else if (option(arg, "warmup", warmups))  continue;
+        else if (option(arg, "reps", reps))       continue;
+        else if (option(arg, "external", external)) continue;
+        else if (option(arg, "sorted", sorted))   continue;
+        else if (option(arg, "memory", memory))   continue;
+        else if (option(arg, "engine", engine))   continue;
+        else if (option(arg, "seed", seed))       continue;
+        else if (option(arg, "payload", payload)) continue;
+        else if (option(arg, "k", ks))            continue;
+        else if (option(arg, "budget", budget))   continue;
+        else if (arg == "--pin")   pin   = true;
+        else if (arg == "--touch") touch = true;
+        else if (arg == "--indirect") indirect = true;
+        else if (arg == "--strings") strings = true;
+        else if (arg == "--hugepages") hugePages = true;
+        else if (arg == "--numa")  numaLocal = true;
+        else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << "error: unknown option " << arg << ".\n";
+            return -1;
+        }
+        else args.push_back(argv[i]);
+    }
+    argc = args.size();
+    argv = args.data();
+    bufferPool::instance().configure(hugePages, numaLocal);
+    if (!external.empty()) {
+        externalSorter sorter;
+        auto name = std::find(sortNames.begin(), sortNames.end(), engine);
+        if (name == sortNames.end() || isSelection(allSorts[name - sortNames.begin()])
+            || !isAvailable(allSorts[name - sortNames.begin()])) {
+            std::cout << "error: unknown engine " << engine << ".\n";
+            return -1;
+        }
+        sorter.engine  = allSorts[name - sortNames.begin()];
+        sorter.memory  = size_t(memory) << 20;
+        sorter.threads = threads;
+        if (sorted.empty()) sorted = external + ".sorted";
+        try {
+            externalResult result = sorter(external, sorted);
+            std::cout << externalResult::header() << "\n"
+                      << result.keys << DELIMITER << engine << DELIMITER << sorter.memory << DELIMITER
+                      << result.runs << DELIMITER << result.fanIn << DELIMITER << result.passes << DELIMITER
+                      << result.runMs << DELIMITER << result.mergeMs << DELIMITER << result.gbPerSecond()
+                      << DELIMITER << result.verifyMs << DELIMITER << result.verified << std::endl;
+            if (!result.verified) std::cout << "[error: sort didn't sort]\n";
+            return result.verified ? 0 : -1;
+        } catch (std::exception &e) {
+            std::cout << "error: " << e.what() << "\n";
+            return -1;
+        }
+    }
     if (argc < 4) {
-        std::cout << "usage: sortstats [start] [stop] [step] <output>\n";
+        std::cout << "usage: sortstats [start] [stop] [step] <output> [--jobs=N] [--pin] [--threads=N]\n"
+                     "                 [--warmup=N] [--reps=K] [--touch] [--seed=S] [--payload=P] [--indirect]\n"
+                     "                 [--k=K1,K2,...] [--budget=MS] [--hugepages] [--numa] [--strings]\n";
         return -1;
     }
 
@@ -34,6 +332,10 @@ int main(int argc, char *argv[]) {
         std::cout << "error: invalid parameter.\n";
         return -1;
     }
+    if (jobs < 1 || threads < 1 || reps < 1) {
+        std::cout << "error: jobs, threads and reps must be natural numbers.\n";
+        return -1;
+    }
     if (ending < starting) {
         std::cout << "error: ending value must be greater than starting value.\n";
         return -1;
@@ -42,6 +344,10 @@ int main(int argc, char *argv[]) {
         std::cout << "error: count must be a natural number.\n";
         return -1;
     }
+    if (payload != 0 && payload != 16 && payload != 64 && payload != 256) {
+        std::cout << "error: payload must be 16, 64 or 256 bytes.\n";
+        return -1;
+    }
     std::ofstream outFile;
     std::ostream* output = &std::cout; // default to cout if no file specified
     if (argc > 4) {
@@ -49,15 +355,26 @@ int main(int argc, char *argv[]) {
         if (outFile.good()) { output = &outFile; }
         else outFile.close();
     }
-    bool verbose = true;
+    // progress messages from several workers would interleave, so they are
+    // only printed for a serial run
+    sweepSettings settings = {jobs, threads, warmups, reps, budget, pin, touch, indirect, jobs == 1, seed, ks};
+    if (strings) {
+        (*output) << stringSorter::header() << std::endl;
+        step = (ending - starting) / count;
+        if (step == 0) step = 1;
+        stringSweep(starting, ending, step, settings, *output);
+        if (outFile) outFile.close();
+        return 0;
+    }
     // write CSV column names first, used by the R script
-    (*output) << "size,sort,initial_order,ms_elapsed,exchanges,compares" << std::endl;
+    (*output) << sortFunctor::header() << std::endl;
     step = (ending - starting) / count;
-    for (indexType i = starting; i <= ending; i += step) {
-        sortFunctor sort(i, verbose);
-        for (Sorts s : allSorts)
-            for (Orders o : allOrders)
-                (*output) << sort(s, o) << std::endl;
+    if (step == 0) step = 1;
+    switch (payload) {
+        case 0:   sweep<sortFunctor>(starting, ending, step, settings, *output); break;
+        case 16:  sweep<basicSortFunctor<countingPolicy, record<16>>>(starting, ending, step, settings, *output); break;
+        case 64:  sweep<basicSortFunctor<countingPolicy, record<64>>>(starting, ending, step, settings, *output); break;
+        case 256: sweep<basicSortFunctor<countingPolicy, record<256>>>(starting, ending, step, settings, *output); break;
     }
     if (outFile) outFile.close();
 } // main
@@ -6,6 +6,8 @@
 //
 // This is the class definition which contains the sorting routines and the
 // statistical measuring and initial dataset generation.
+// the functor is a template over a counting policy, so the same engines can be
+// run counting every operation or compiled down to bare comparisons for timing.
 // 
 // the quicksort algorithm comes from Robert Sedgewick (Princeton) adapted from java:
 // http://algs4.cs.princeton.edu/23quicksort/
@@ -13,148 +15,586 @@
 // the heapsort algorithm comes from Doug Baldwin (SUNY Geneseo)
 // http://www.geneseo.edu/~baldwin/csci240/spring2007/0427siftdown.html
 //
-// the random number algorithm comes from: 
-// http://codereview.stackexchange.com/questions/109260/seed-stdmt19937-from-stdrandom-device
+// the introsort follows Orson Peters' pattern-defeating quicksort:
+// https://github.com/orlp/pdqsort
+// and its branchless partition is from Stefan Edelkamp and Armin Weiss,
+// "BlockQuicksort: How Branch Mispredictions don't affect Quicksort":
+// https://arxiv.org/abs/1604.06697
+//
+// the selection algorithm of Robert Floyd and Ronald Rivest is from their
+// "Algorithm 489: SELECT", Communications of the ACM 18(3), 1975
+//
+// the adaptive merge sort follows Tim Peters' timsort, including the fix to
+// its run stack invariant from de Gouw et al.:
+// https://github.com/python/cpython/blob/main/Objects/listsort.txt
+//
+// the auto engine samples how presorted its input is (runs, inversions and
+// distinct keys) and dispatches to whichever engine suits that best.
+//
+// std_sort, std_stable_sort, std_partial_sort and std_sort_par_unseq run the
+// standard library's sorts, counted through the wrappers in libraryAdapters.hpp.
+// std_sort_par_unseq needs C++17 and its <execution> header (with libstdc++,
+// link with -ltbb); without them it isn't available and the sweep skips it.
+//
+// the input orders and their generator are in inputGenerator.hpp.  the engines
+// sort bare sortType keys by default, or any element type from records.hpp:
+// records with a payload, or indexes into an array of records.
 //
 //////////////////////////////////////////////////////////////////////////////////
 #ifndef __sortFunctor__
 #define __sortFunctor__
 #include <chrono>
+#include <cmath>
 #include <random>
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <iomanip>
 #include <array>
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <stdlib.h>
+#include "sortingNetwork.hpp"
+#include "perfCounters.hpp"
+#include "inputGenerator.hpp"
+#include "records.hpp"
+#include "libraryAdapters.hpp"
+#include "cellBudget.hpp"
+#include "bufferPool.hpp"
+#include "verification.hpp"
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<execution>)
+#include <execution>
+#define PARALLELSTL
+#endif
+#endif
 
 #define DELIMITER ','
-#define ALMOST 10
-typedef size_t sortType;
+#define INSERTION 16   // introsort hands ranges this small to insertion sort
+#define NINTHER 128    // introsort uses a ninther pivot above this size
+#define PARTIAL 8      // element moves allowed before giving up on a presorted range
+#define BUCKETS 256    // buckets per radix sort digit, one byte at a time
+#define SAMPLEMIN 4096 // sample sort hands smaller arrays straight to introsort
+#define SAMPLEBUCKETS 4 // sample sort buckets per thread, for load balancing
+#define OVERSAMPLE 32  // sample sort keys sampled per bucket
+#define EVICTBYTES (64 << 20) // swept before a touched repetition, bigger than the LLC
+#define CACHELINE 64   // bytes, the working buffers are aligned to this
+#define MINMERGE 64    // merge sort insertion sorts smaller arrays, and runs are extended to about half this
+#define MINGALLOP 7    // wins in a row before a merge starts galloping
+#define SELECTSAMPLE 600 // floyd-rivest narrows ranges bigger than this by recursing on a sample
+#define PARTITIONBLOCK 64 // keys classified at a time by the branchless partition, at most 256
+#define POLLEVERY 64   // partitions, sift-downs or runs between the engines' budget checks
+#define AUTOSAMPLE 256  // keys the auto engine samples for each of its estimates
+#define AUTOWINDOW 16  // neighbours per window when auto counts descents
+#define AUTORUN 256    // estimated average run length from which auto merges the runs
+#define AUTORADIX 4096 // auto only radix sorts arrays at least this big
+#define AUTORECORD 128 // or elements at most this big, since every pass moves all of them
+#define AUTODISTINCT 0.1 // sampled fraction of distinct keys below which auto doesn't radix sort
+#define AUTONEAR 0.05  // inverted fraction of sampled pairs (or of non-inverted ones) that counts as nearly sorted
+static_assert(sizeof(sortType) == sizeof(uint64_t), "the sorting networks work on 64-bit keys");
 typedef size_t countType;
-typedef size_t indexType;
-struct sortFunctor;
-typedef void (sortFunctor::*sortFunction)(sortType *, indexType);
 typedef std::chrono::high_resolution_clock        Clock;
 typedef std::chrono::time_point<Clock>            Timer;
 typedef std::chrono::duration<double, std::milli> Duration;
 
-enum class Sorts  : int { SELECTION, QUICK, HEAP};
-const std::array<Sorts, 3> allSorts = {Sorts::SELECTION, Sorts::QUICK, Sorts::HEAP};
-const std::array<std::string, 3> sortNames = {"selection", "quicksort", "heapsort"};
-enum class Orders : int { FORWARD, ALMOSTFORWARD, UNIFORM, ALMOSTREVERSE, REVERSE};
-const std::array<Orders, 5> allOrders = {Orders::FORWARD, Orders::ALMOSTFORWARD, 
-                                         Orders::UNIFORM, Orders::ALMOSTREVERSE, Orders::REVERSE};
-const std::array<std::string, 5> orderNames = {"forward_sorted", "almost_forward", 
-                                               "shuffled_randm", "almost_reverse", "reverse_sorted"};
-static constexpr int cast(Orders a) { return static_cast<int>(a); }
+enum class Sorts  : int { SELECTION, QUICK, HEAP, INTRO, RADIX, SAMPLE, DHEAP, MERGE, BLOCKQUICK,
+                          INTROSELECT, FLOYDRIVEST, TOPK, AUTO, STDSORT, STDSTABLE, STDPARTIAL, STDPARALLEL};
+const std::array<Sorts, 17> allSorts = {Sorts::SELECTION, Sorts::QUICK, Sorts::HEAP, Sorts::INTRO, Sorts::RADIX,
+                                        Sorts::SAMPLE, Sorts::DHEAP, Sorts::MERGE, Sorts::BLOCKQUICK,
+                                        Sorts::INTROSELECT, Sorts::FLOYDRIVEST, Sorts::TOPK, Sorts::AUTO,
+                                        Sorts::STDSORT, Sorts::STDSTABLE, Sorts::STDPARTIAL, Sorts::STDPARALLEL};
+const std::array<std::string, 17> sortNames = {"selection", "quicksort", "heapsort", "introsort", "radix",
+                                               "samplesort", "dheapsort", "mergesort", "blockquicksort",
+                                               "introselect", "floyd_rivest", "heap_topk", "auto",
+                                               "std_sort", "std_stable_sort", "std_partial_sort",
+                                               "std_sort_par_unseq"};
 static constexpr int cast(Sorts  a) { return static_cast<int>(a); }
 
-template<class T = std::mt19937, std::size_t N = T::state_size>
-auto ProperlySeededRandomEngine () -> typename std::enable_if<!!N, T>::type {
-        typename T::result_type random_data[N];
-            std::random_device source;
-                std::generate(std::begin(random_data), std::end(random_data), std::ref(source));
-                    std::seed_seq seeds(std::begin(random_data), std::end(random_data));
-                        T seededEngine (seeds);
-                            return seededEngine;
+// the selection engines only put the k smallest keys in front: introselect
+// and floyd-rivest leave the k-th smallest at index k-1 with nothing bigger
+// before it and nothing smaller after it, heap_topk and std_partial_sort
+// also sort those k keys
+static constexpr bool isSelection(Sorts a) {
+    return a == Sorts::INTROSELECT || a == Sorts::FLOYDRIVEST || a == Sorts::TOPK || a == Sorts::STDPARTIAL;
+}
+static constexpr bool sortsSelection(Sorts a) { return a == Sorts::TOPK || a == Sorts::STDPARTIAL; }
+
+// whether this build can run a sort at all
+static constexpr bool isAvailable(Sorts a) {
+#ifdef PARALLELSTL
+    (void)a;
+    return true;
+#else
+    return a != Sorts::STDPARALLEL;
+#endif
+}
+
+// working buffers come from the pool already faulted in, and page aligned, so
+// a d-ary heap's child blocks each sit in exactly one cache line
+template <class Element>
+static Element *allocateElements(indexType n) {
+    return static_cast<Element *>(bufferPool::instance().acquire(n * sizeof(Element)));
 }
+static void freeElements(void *elements) { bufferPool::instance().release(elements); }
 
-struct sortFunctor {
-    countType exchanges, comparisons;
+// summary of the timed repetitions of one cell
+struct timingStats {
+    double min, median, p95, stddev;
+    timingStats(std::vector<double> times) {
+        std::sort(times.begin(), times.end());
+        size_t K = times.size();
+        min    = times[0];
+        median = K % 2 ? times[K / 2] : (times[K / 2 - 1] + times[K / 2]) / 2;
+        p95    = times[(95 * K + 99) / 100 - 1];     // nearest rank
+        double mean = 0, squares = 0;
+        for (double t : times) mean += t / K;
+        for (double t : times) squares += (t - mean) * (t - mean);
+        stddev = K > 1 ? std::sqrt(squares / (K - 1)) : 0;
+    }
+};
+
+// instrumentation policies.  the engines report every comparison, exchange
+// and byte moved through Counting::count, which either adds to the counter or
+// compiles away to nothing, leaving bare inline comparisons to be timed.
+struct countingPolicy {
+    static const bool counts = true;
+    static void count(countType &counter, countType n = 1) { counter += n; }
+};
+struct barePolicy {
+    static const bool counts = false;
+    static void count(countType &, countType = 1) {}
+};
+
+// the auto engine's estimates of how presorted an input is
+struct presortedness {
+    double runs = 0;        // ascending or descending runs, from the turns in sampled windows
+    double inversions = 0;  // fraction of sampled pairs which are out of order
+    double distinct = 0;    // fraction of distinct keys in a sample
+};
+
+// sortFunctor counts operations.  when it runs a cell it also runs the same
+// sort on a barePolicy twin sharing its inputs, and reports the twin's time
+// as ms_elapsed so the timing doesn't include the counting overhead.
+template <class Counting, class Element = sortType> struct basicSortFunctor;
+typedef basicSortFunctor<countingPolicy> sortFunctor;
+typedef basicSortFunctor<barePolicy>     bareSortFunctor;
+
+template <class Counting, class Element>
+struct basicSortFunctor {
+    typedef basicSortFunctor<barePolicy, Element> bareFunctor;
+    typedef basicSortFunctor<Counting, recordIndex> indexFunctor;
+    typedef void (basicSortFunctor::*sortFunction)(Element *, indexType);
+    countType exchanges, comparisons, bytesMoved;
+    countType merges, gallops;   // merge sort only: runs merged and galloping searches
     sortFunction sorter;
+    Sorts selected;
     Timer startTime, endTime;
     // Duration duration;
     indexType N;
-    sortType *data;
-    sortType *inputs[allOrders.size()];
+    Element *data;
+    // the input sets are read-only once generated, so copies of a functor share
+    // them and only get their own working buffer
+    std::shared_ptr<inputSets> inputs;
+    std::shared_ptr<inputHashes> hashes;    // of the input sets, for verified()
     bool verbose;
-    std::mt19937 rd;
-    std::uniform_int_distribution<sortType> dist;
+    unsigned threads = 1;    // worker threads for the parallel engines
+    unsigned warmups = 0;    // untimed runs of each cell before timing it
+    unsigned repetitions = 1;// timed runs of each cell, each on a fresh copy
+    bool touch = false;      // evict the caches and re-touch the buffers before each run
+    bool indirect = false;   // sort an index array, then permute the elements once
+    indexType rank = 0;      // the k of the selection engines, 0 for the median
+    xoshiro256 rd;           // reseeded by reset(), so every run of a cell draws the same samples
+    std::unique_ptr<bareFunctor> bare;      // untimed twin, counting functors only
+    perfCounters counters;                  // hardware counters around the sort
+    pooled<Element> mergeBuffer;            // merge sort scratch, kept between merges and runs
+    int minGallop = MINGALLOP;
+    keyTable table;                         // where index elements find their keys
+    std::unique_ptr<indexFunctor> indexer;  // sorts the index array of an indirect sort
+    std::vector<recordIndex> indexes;
+    // what the auto engine estimated on its last run, what it picked ("none"
+    // if the input was already sorted), and how long deciding took
+    presortedness sampled;
+    std::string dispatched;
+    Clock::duration samplingTime{};
+    // with a budget, the engines poll the deadline and throw overBudget once
+    // it has passed (see cellBudget.hpp).  the standard library's sorts can't
+    // be stopped, only skipped when the model says they won't make it
+    bool budgeted = false;
+    Timer deadline;
+    unsigned polls = 0;
+    double elapsed = 0;                     // ms_elapsed of the last cell
+    // when the runs ms_elapsed comes from began, and how many there are, so
+    // an aborted cell can bound its time by the same measure
+    Timer timedStart{};
+    unsigned timedRuns = 0;
+    long faults = 0;                        // page faults taken during the last run
+    multisetHash expected;                  // of the input the last run started from
+    Clock::duration verifyTime{};           // how long checking the last run's output took
 
-    ~sortFunctor() {
-       for (Orders o : allOrders)
-          delete inputs[cast(o)]; 
+    ~basicSortFunctor() {
+       freeElements(data);
     }
 
-    sortFunctor(indexType N = 100, bool verbose = false) {
+    // the input sets are generated lazily, the first time a cell uses them,
+    // and can be reproduced from the seed
+    basicSortFunctor(indexType N = 100, bool verbose = false, uint64_t seed = randomSeed()) {
         this->verbose = verbose;
         this->N = N;
-        //inputs.reserve(allOrders.size());
-        rd = ProperlySeededRandomEngine();
-        dist = std::uniform_int_distribution<sortType>(0, N - 1);
-        if(verbose) std::cout << "building input sets of size " << N << ":\n" ;
-        for (Orders o : allOrders) {
-            inputs[cast(o)] = new sortType[N];
-            generateInput(inputs[cast(o)], N, o);
-            //if (verbose) print(inputs[cast(o)], N);
-        }
-        data = new sortType[N];
-        if(verbose) std::cout << "done." << std::endl;
+        inputs = std::make_shared<inputSets>(N, seed);
+        hashes = std::make_shared<inputHashes>(inputs);
+        rd = xoshiro256(mixSeed(seed, N));
+        if(verbose) std::cout << "input sets of size " << N << ", seed " << seed << std::endl;
+        data = allocateElements<Element>(N);
     }
 
-    void reset(Sorts S, Orders O) {
+    // copying a functor shares the generated input sets but allocates fresh
+    // working data and counters, so each copy can run a cell on its own thread.
+    // a functor can be copied to the other counting policy the same way.
+    basicSortFunctor(const basicSortFunctor &other, bool verbose = false) { share(other, verbose); }
+    template <class Other>
+    basicSortFunctor(const basicSortFunctor<Other, Element> &other, bool verbose = false) { share(other, verbose); }
+    basicSortFunctor &operator=(const basicSortFunctor &) = delete;
+
+    private:
+    template <class Other, class OtherElement> friend struct basicSortFunctor;
+    template <class Other>
+    void share(const basicSortFunctor<Other, Element> &other, bool verbose) {
+        this->verbose = verbose;
+        N       = other.N;
+        threads = other.threads;
+        warmups = other.warmups;
+        repetitions = other.repetitions;
+        touch   = other.touch;
+        indirect = other.indirect;
+        rank    = other.rank;
+        rd      = other.rd;
+        inputs  = other.inputs;
+        hashes  = other.hashes;
+        data = allocateElements<Element>(N);
+    }
+
+    // a worker for one thread of a parallel engine.  it has no buffers of its
+    // own and only exists to keep that thread's counters apart from the others
+    struct counterOnly {};
+    basicSortFunctor(const basicSortFunctor &other, counterOnly) {
+        verbose     = false;
+        N           = 0;
+        threads     = 1;
+        rd          = other.rd;
+        table       = other.table;
+        data        = nullptr;
         exchanges   = 0;
         comparisons = 0;
-        // select the sorting algorithm
+        bytesMoved  = 0;
+        merges      = 0;
+        gallops     = 0;
+    }
+
+    public:
+
+    // select the sorting algorithm and clear the counters
+    void select(Sorts S) {
+        exchanges   = 0;
+        comparisons = 0;
+        bytesMoved  = 0;
+        merges      = 0;
+        gallops     = 0;
+        selected    = S;
+        sorter      = engine(S);
+        dispatched.clear();
+    }
+
+    static sortFunction engine(Sorts S) {
         switch (S) {
-            case Sorts::SELECTION: sorter = &sortFunctor::selectionSort; break;
-            case Sorts::QUICK:     sorter = &sortFunctor::quickSort;     break;
-            case Sorts::HEAP:      sorter = &sortFunctor::heapSort;      break;
+            case Sorts::SELECTION: return &basicSortFunctor::selectionSort;
+            case Sorts::QUICK:     return &basicSortFunctor::quickSort;
+            case Sorts::HEAP:      return &basicSortFunctor::heapSort;
+            case Sorts::INTRO:     return &basicSortFunctor::introSort;
+            case Sorts::RADIX:     return &basicSortFunctor::radixSort;
+            case Sorts::SAMPLE:    return &basicSortFunctor::sampleSort;
+            case Sorts::DHEAP:     return &basicSortFunctor::dheapSort;
+            case Sorts::MERGE:     return &basicSortFunctor::mergeSort;
+            case Sorts::BLOCKQUICK: return &basicSortFunctor::blockQuickSort;
+            case Sorts::INTROSELECT: return &basicSortFunctor::introSelect;
+            case Sorts::FLOYDRIVEST: return &basicSortFunctor::floydRivest;
+            case Sorts::TOPK:      return &basicSortFunctor::heapTopK;
+            case Sorts::AUTO:      return &basicSortFunctor::autoSort;
+            case Sorts::STDSORT:   return &basicSortFunctor::stdSort;
+            case Sorts::STDSTABLE: return &basicSortFunctor::stdStableSort;
+            case Sorts::STDPARTIAL: return &basicSortFunctor::stdPartialSort;
+            case Sorts::STDPARALLEL: return &basicSortFunctor::stdParallelSort;
         }
+        return &basicSortFunctor::introSort;
+    }
+
+    void reset(Sorts S, Orders O) {
+        select(S);
+        // the timed runs on the bare twin have to sample (auto) and pick
+        // splitters (samplesort) just as the counted run did
+        rd = xoshiro256(mixSeed(inputs->seed, N));
         // copy the pre-initialized starting data to the working data
-        std::copy(inputs[cast(O)], inputs[cast(O)] + N, data); 
+        const sortType *input = inputs->keys(O);
+        for (indexType i = 0; i < N; i++) makeElement(data[i], input[i]);
+        expected = hashes->of(O);
+        // built here rather than on the clock, and before timeSort reserves
+        // the scratch buffers, so its own small buffer is mapped first
+        if (indirect && !indexer) indexer.reset(new indexFunctor(0));
+        if (indirect) indexes.resize(N);
+        // the merges never need more than half, and auto may merge
+        if (S == Sorts::MERGE || S == Sorts::AUTO) {
+            if (indirect) indexer->growMergeBuffer(N);
+            else growMergeBuffer(N);
+        }
     }
 
-    std::string operator()(Sorts S, Orders O) {
-        std::ostringstream buffer;
+    void growMergeBuffer(indexType n) {
+        if (mergeBuffer.size() < n / 2 + 1) mergeBuffer = pooled<Element>(n / 2 + 1);
+    }
+
+    // sort an array which isn't one of the generated inputs, e.g. one run of
+    // an external sort.  a functor built with N = 0 is enough for this.
+    void sortArray(Sorts S, Element *arr, indexType n) {
+        select(S);
+        (*this.*sorter)(arr, n);
+    }
+
+    // perform one sort on a fresh copy of the input, verify it and return the
+    // time elapsed
+    Clock::duration timeSort(Sorts S, Orders O) {
         reset(S, O);
-        if (verbose) std::cout << "sort: N=" << N << ", " << orderNames[cast(O)] << ", " << sortNames[cast(S)] << "... ";
-        std::cout.flush();
-        // perform the sort and measure time elapsed
+        // radix and sample sort take an N element scratch buffer from the
+        // pool, of indexes when the sort is indirect, and sample sort its
+        // sample and the bucket of every key too
+        const size_t element = indirect ? sizeof(recordIndex) : sizeof(Element);
+        if (S == Sorts::SAMPLE)
+            bufferPool::instance().reserve({N * element, N * sizeof(indexType),
+                                            threads * SAMPLEBUCKETS * OVERSAMPLE * element});
+        else bufferPool::instance().reserve(N * element);
+        if (touch) touchBuffers(O);
+        long faulted = pageFaults();
+        counters.start();
         startTime = std::chrono::system_clock::now();
-        (*this.*sorter)(data, N);
+        if (indirect) sortIndirect(data, N);
+        else (*this.*sorter)(data, N);
         endTime   = std::chrono::system_clock::now();
-        auto duration  = endTime - startTime;
-        // verify the list is now sorted
-        if (!equal(data, inputs[cast(Orders::FORWARD)], N)) { 
+        counters.stop();
+        faults = pageFaults() - faulted;
+        // verify the list is now sorted, or the selection made
+        auto verifying = Clock::now();
+        bool correct = verified(S);
+        verifyTime = Clock::now() - verifying;
+        if (!correct) {
             std::cout << "[error: sort didn't sort] ";
             print(data, N); 
         }
-        // output CSV
+        return endTime - startTime;
+    }
+
+    // the indirect (argsort) mode: the selected engine sorts 32-bit indexes
+    // of the elements by their keys, then every element is moved straight to
+    // its place by following the cycles of that permutation, so each one is
+    // moved once.  the index sort's counts are added to this functor's.
+    void sortIndirect(Element *arr, indexType n) {
+        if (n > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("an indirect sort can only index 2^32 elements.");
+        if (!indexer) indexer.reset(new indexFunctor(0));
+        indexer->threads      = threads;
+        indexer->rank         = rank;
+        indexer->budgeted     = budgeted;
+        indexer->deadline     = deadline;
+        indexer->rd           = rd;
+        indexer->table.base   = reinterpret_cast<const char *>(arr);
+        indexer->table.stride = sizeof(Element);
+        indexes.resize(n);
+        for (indexType i = 0; i < n; i++) indexes[i].index = i;
+        indexer->sortArray(selected, indexes.data(), n);
+        exchanges   += indexer->exchanges;
+        comparisons += indexer->comparisons;
+        bytesMoved  += indexer->bytesMoved;
+        merges      += indexer->merges;
+        gallops     += indexer->gallops;
+        sampled      = indexer->sampled;
+        dispatched   = indexer->dispatched;
+        samplingTime = indexer->samplingTime;
+        for (indexType i = 0; i < n; i++) {
+            if (indexes[i].index == i) continue;
+            Element displaced = arr[i];
+            indexType hole = i, moves = 1;
+            for (indexType from = indexes[hole].index; from != i; from = indexes[hole].index, moves++) {
+                arr[hole] = arr[from];
+                indexes[hole].index = hole;
+                hole = from;
+            }
+            arr[hole] = displaced;
+            indexes[hole].index = hole;
+            Counting::count(bytesMoved, (moves + 1) * sizeof(Element));
+        }
+    } // void sortIndirect
+
+    // the CSV column names matching operator()'s rows, used by the R script
+    static std::string header() {
+        return "size,sort,initial_order,ms_elapsed,exchanges,compares,bytes_moved,merges,gallops,threads,"
+               "record_bytes,indirect,k,ms_counted,reps,ms_min,ms_median,ms_p95,ms_stddev,"
+               "dispatch,est_runs,est_inversions,est_distinct,ms_sampling,page_faults,ms_verify" + perfCounters::header(DELIMITER)
+               + ",seed,extrapolated,model";
+    }
+
+    // the row for a cell which wasn't measured, with ms_elapsed (in clock
+    // ticks, like every time column) from a complexity model and the other
+    // measurements left empty.  negative ticks leave ms_elapsed empty too.
+    std::string extrapolatedRow(Sorts S, Orders O, double ticks, const std::string &model) {
+        std::ostringstream buffer;
+        const std::string hardware = perfCounters::header(DELIMITER);
+        buffer << std::fixed << std::setprecision(0);
+        buffer << N << DELIMITER << sortNames[cast(S)] << DELIMITER << orderNames[cast(O)] << DELIMITER;
+        if (ticks >= 0) buffer << ticks;
+        buffer << std::string(5, DELIMITER) << DELIMITER << threads << DELIMITER << sizeof(Element)
+               << DELIMITER << indirect << DELIMITER << (isSelection(S) ? selectRank(N) : N)
+               << DELIMITER << DELIMITER << 0 << std::string(4, DELIMITER) << std::string(7, DELIMITER)
+               << std::string(std::count(hardware.begin(), hardware.end(), DELIMITER), DELIMITER)
+               << DELIMITER << inputs->seed << DELIMITER << 1 << DELIMITER << model;
+        if (verbose && ticks < 0) std::cout << "sort: N=" << N << ", " << orderNames[cast(O)] << ", "
+                                            << sortNames[cast(S)] << "... " << model << ".\n";
+        else if (verbose) std::cout << "sort: N=" << N << ", " << orderNames[cast(O)] << ", " << sortNames[cast(S)]
+                                    << "... extrapolated: " << Duration(Clock::duration(Clock::rep(ticks))).count()
+                                    << " ms (" << model << ").\n";
+        return buffer.str();
+    }
+
+    std::string operator()(Sorts S, Orders O) {
+        std::ostringstream buffer;
+        if (verbose) std::cout << "sort: N=" << N << ", " << orderNames[cast(O)] << ", " << sortNames[cast(S)] << "... ";
+        std::cout.flush();
+        // the counts come from one counted run, the times from the warmed up
+        // repetitions on the bare twin.  the hardware counters, page faults and
+        // verification time are the last repetition's.
+        timedStart = Clock::now();
+        timedRuns  = Counting::counts ? 0 : 1;
+        auto counted  = timeSort(S, O);
+        std::vector<double> times;
+        perfCounters *hardware = &counters;
+        Clock::duration sampling = samplingTime;
+        long faulted = faults;
+        Clock::duration verifying = verifyTime;
+        if (Counting::counts) {
+            if (!bare) bare.reset(new bareFunctor(*this));
+            bare->threads  = threads;
+            bare->indirect = indirect;
+            bare->rank     = rank;
+            bare->budgeted = budgeted;
+            bare->deadline = deadline;
+            timedStart = Clock::now();
+            timedRuns  = warmups + repetitions;
+            for (unsigned w = 0; w < warmups; w++) bare->timeSort(S, O);
+            for (unsigned r = 0; r < repetitions; r++) times.push_back(bare->timeSort(S, O).count());
+            hardware = &bare->counters;
+            sampling = bare->samplingTime;
+            faulted  = bare->faults;
+            verifying = bare->verifyTime;
+        } else times.push_back(counted.count());
+        timingStats stats(times);
+        elapsed = stats.median;
+        // output CSV, times in whole clock ticks as before
+        buffer << std::fixed << std::setprecision(0);
         buffer << N << DELIMITER << sortNames[cast(S)] << DELIMITER << orderNames[cast(O)] << DELIMITER
-               << duration.count() << DELIMITER << exchanges << DELIMITER << comparisons;
-        if (verbose) std::cout << "done: " << exchanges << " exch, " << comparisons << " cmps, " << duration.count() << " ms.\n";
+               << stats.median << DELIMITER << exchanges << DELIMITER << comparisons << DELIMITER << bytesMoved
+               << DELIMITER << merges << DELIMITER << gallops << DELIMITER << threads
+               << DELIMITER << sizeof(Element) << DELIMITER << indirect
+               << DELIMITER << (isSelection(S) ? selectRank(N) : N) << DELIMITER << counted.count()
+               << DELIMITER << times.size() << DELIMITER << stats.min << DELIMITER << stats.median
+               << DELIMITER << stats.p95 << DELIMITER << stats.stddev << DELIMITER;
+        // the auto engine's columns are left empty for the other sorts
+        if (S == Sorts::AUTO)
+            buffer << dispatched << DELIMITER << sampled.runs << std::setprecision(3) << DELIMITER
+                   << sampled.inversions << DELIMITER << sampled.distinct << std::setprecision(0)
+                   << DELIMITER << sampling.count();
+        else buffer << DELIMITER << DELIMITER << DELIMITER << DELIMITER;
+        buffer << DELIMITER << faulted << DELIMITER << verifying.count() << hardware->csv(DELIMITER) << DELIMITER << inputs->seed << DELIMITER << 0 << DELIMITER;
+        if (verbose && S == Sorts::AUTO) std::cout << "dispatched to " << dispatched << ", ";
+        if (verbose) std::cout << "done: " << exchanges << " exch, " << comparisons << " cmps, " << bytesMoved << " bytes, "
+                               << stats.median << " ms (" << counted.count() << " counted).\n";
         return buffer.str();
     }
 
+    // stream through a buffer bigger than the last level cache, then read one
+    // word from every page of the working data and its input set, so that a
+    // run starts with its pages mapped but nothing left in cache from the copy
+    // or from whatever ran before it
+    void touchBuffers(Orders O) {
+        static const std::vector<char> evict(EVICTBYTES, 1);
+        const indexType page = 4096 / sizeof(Element);
+        volatile sortType sink = 0;
+        for (size_t i = 0; i < evict.size(); i += 64) sink += evict[i];
+        for (indexType i = 0; i < N; i += page) sink += keyOf(data[i]);
+        const sortType *input = inputs->keys(O);
+        for (indexType i = 0; i < N; i += page) sink += input[i];
+    }
+
     // print a list
-    void print(sortType *a, indexType N) {
+    void print(Element *a, indexType N) {
         std::cout << "{ ";
-        for (int i = 0; i < N; i++) std::cout << a[i] << " ";
+        for (int i = 0; i < N; i++) std::cout << keyOf(a[i]) << " ";
         std::cout << "}\n";
     }
 
-    // test that two lists contains the same elements
-    bool equal(sortType *a, sortType *b, indexType N) {
-        bool result = true;
-        for (indexType i = 0; result && i < N; i++) if(a[i] != b[i]) result = false;
-        return result;
+    // test the working data against the input's multiset hash in one pass
+    // (see verification.hpp): a full sort has to be in order, and a selection
+    // has nothing bigger than its k-th key before it and nothing smaller after
+    // it, which with the same keys as the input makes it the k-th smallest.
+    // with sortsSelection the first k have to be in order too.  records also
+    // have to keep their own payloads.
+    bool verified(Sorts S) {
+        streamingVerifier output;
+        bool correct = true;
+        if (!isSelection(S)) {
+            addKeys(output, data, N);
+            correct = output.sorted();
+        } else if (N > 0) {
+            indexType k = selectRank(N);
+            addKeys(output, data, k);
+            sortType kth = keyOf(data[k - 1]);
+            if (sortsSelection(S)) correct = output.sorted();
+            else for (indexType i = 0; i + 1 < k; i++) if (kth < keyOf(data[i])) correct = false;
+            for (indexType i = k; i < N; i++) {
+                sortType key = keyOf(data[i]);
+                if (key < kth) correct = false;
+                output.hash.add(key);
+            }
+        }
+        for (indexType i = 0; correct && i < N; i++) if (!intact(data[i])) correct = false;
+        return correct && output.hash == expected;
+    }
+
+    // bare keys go through the vector order check, other elements one key at a time
+    void addKeys(streamingVerifier &output, const sortType *a, indexType n) { output.add(a, n); }
+    template <class Other>
+    void addKeys(streamingVerifier &output, const Other *a, indexType n) {
+        for (indexType i = 0; i < n; i++) output.add(keyOf(a[i]));
     }
+
+    // how many keys the selection engines select out of n
+    indexType selectRank(indexType n) const { return rank == 0 ? (n + 1) / 2 : std::min(rank, n); }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // here are the sorts exposed to the API
 // they should all share the same parameter list, 
 // and have their subroutines as private methods below
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    void quickSort(sortType *arr, indexType N) {
+    void quickSort(Element *arr, indexType N) {
         quickSplit(arr, 0, N-1);
     }
 
-    void selectionSort(sortType *arr, indexType N) {
+    void selectionSort(Element *arr, indexType N) {
         indexType i, j, minIndex;    
         for (i = 0; i < N - 1; i++) {
+            pollBudget(1);
             minIndex = i;
             for (j = i + 1; j < N; j++)
                 if (compare(arr, j, minIndex) < 0)
@@ -164,44 +604,431 @@ struct sortFunctor {
         }
     }
 
-    void heapSort(sortType *arr, indexType N) {       
+    void heapSort(Element *arr, indexType N) {       
         for (long k = N >> 1; k >= 0; k--) {
+            pollBudget(POLLEVERY);
             heapSiftDown(arr, k, N);    
         }
         while (N - 1 > 0) {  
+            pollBudget(POLLEVERY);
             exchange(arr, N - 1, 0); 
             heapSiftDown(arr, 0, N - 1);  
             N--;
         }
     }
 
+    // heapsort on a heapArity()-ary heap laid out so every node's children fill
+    // exactly one cache line: the root's children are 1 .. d-1 and node h's
+    // are d*h .. d*h+d-1.  it is iterative, sifts down bottom-up (Floyd), and
+    // prefetches the grandchildren while it compares the children.
+    void dheapSort(Element *arr, indexType N) {
+        if (N < 2) return;
+        for (indexType i = dheapParent(N - 1) + 1; i-- > 0; ) {
+            pollBudget(POLLEVERY);
+            dheapSiftDown(arr, i, N);
+        }
+        for (indexType end = N - 1; end > 0; end--) {
+            pollBudget(POLLEVERY);
+            exchange(arr, 0, end);
+            dheapSiftDown(arr, 0, end);
+        }
+    }
+
+    void introSort(Element *arr, indexType N) {
+        if (N < 2) return;
+        introSplit(arr, 0, N, 2 * log2floor(N));
+    }
+
+    // introsort with a branchless block partition instead of the scanning
+    // one.  a block of keys is compared against the pivot first, recording
+    // the offsets of the ones on the wrong side without branching on the
+    // comparisons, and only then are they swapped, so the comparisons don't
+    // mispredict however random the keys are.  few unique keys are handled
+    // the same way as in introsort: a pivot equal to the key before its range
+    // splits off every key equal to it in one pass, and those are done.
+    void blockQuickSort(Element *arr, indexType N) {
+        if (N < 2) return;
+        introSplit(arr, 0, N, 2 * log2floor(N), true);
+    }
+
+    // least significant digit first, one byte per pass.  all of the digit
+    // histograms are built in a single read pass, and a digit where every key
+    // falls into the same bucket is skipped since it can't reorder anything.
+    // keys spread over a range much wider than N (e.g. a few huge outliers)
+    // would need more passes than an MSD sort needs levels, so those go to
+    // msdSplit instead.  radix sort doesn't compare, it reports bytes moved.
+    void radixSort(Element *arr, indexType N) {
+        if (N < 2) return;
+        const int digits = sizeof(sortType);
+        indexType counts[digits][BUCKETS] = {};
+        for (indexType i = 0; i < N; i++)
+            for (int d = 0; d < digits; d++)
+                counts[d][digitOf(keyOf(arr[i]), d)]++;
+        bool active[digits];
+        int passes = 0, top = 0;
+        for (int d = 0; d < digits; d++) {
+            active[d] = counts[d][digitOf(keyOf(arr[0]), d)] != N;
+            if (active[d]) { passes++; top = d; }
+        }
+        if (passes == 0) return;
+        pooled<Element> scratch(N);
+        if (passes > msdLevels(N) + 1) {
+            msdSplit(arr, scratch.data(), 0, N, top);
+            return;
+        }
+        Element *from = arr, *to = scratch.data();
+        for (int d = 0; d < digits; d++) {
+            if (!active[d]) continue;
+            pollBudget(1);
+            indexType offset[BUCKETS], sum = 0;
+            for (int b = 0; b < BUCKETS; b++) { offset[b] = sum; sum += counts[d][b]; }
+            for (indexType i = 0; i < N; i++)
+                to[offset[digitOf(keyOf(from[i]), d)]++] = from[i];
+            Counting::count(bytesMoved, N * sizeof(Element));
+            std::swap(from, to);
+        }
+        if (from != arr) {
+            std::copy(from, from + N, arr);
+            Counting::count(bytesMoved, N * sizeof(Element));
+        }
+    } // void radixSort
+
+    // parallel sample sort on `threads` threads.  splitters are picked from a
+    // sorted random sample, then each thread classifies its own block of the
+    // input, the blocks are scattered into buckets, and the threads take turns
+    // pulling buckets off a shared counter and introsorting them.  every
+    // thread counts into its own worker, and those are added up at the end.
+    void sampleSort(Element *arr, indexType N) {
+        unsigned T = threads;
+        if (T < 2 || N < SAMPLEMIN) {
+            introSort(arr, N);
+            return;
+        }
+        const indexType B = T * SAMPLEBUCKETS;
+        std::uniform_int_distribution<indexType> pick(0, N - 1);
+        pooled<Element> sample(B * OVERSAMPLE);
+        for (indexType i = 0; i < sample.size(); i++) sample[i] = arr[pick(rd)];
+        introSort(sample.data(), sample.size());
+        std::vector<Element> splitters;
+        for (indexType b = 1; b < B; b++) splitters.push_back(sample[b * OVERSAMPLE]);
+
+        std::vector<std::unique_ptr<basicSortFunctor>> workers;
+        for (unsigned t = 0; t < T; t++) workers.emplace_back(new basicSortFunctor(*this, counterOnly()));
+        auto parallel = [&](std::function<void(unsigned, indexType, indexType)> f) {
+            std::vector<std::thread> pool;
+            for (unsigned t = 0; t < T; t++)
+                pool.emplace_back(f, t, N * t / T, N * (t + 1) / T);
+            for (auto &p : pool) p.join();
+        };
+
+        // the workers don't poll, so the budget is checked between the phases
+        pollBudget(1);
+        // classify each thread's block, remembering the bucket of every key
+        pooled<indexType> bucketOf(N);
+        std::vector<indexType> counts(T * B, 0);
+        parallel([&](unsigned t, indexType lo, indexType hi) {
+            for (indexType i = lo; i < hi; i++) {
+                bucketOf[i] = workers[t]->findBucket(splitters, arr[i]);
+                counts[t * B + bucketOf[i]]++;
+            }
+        });
+        // bucket-major prefix sum gives every thread its own slice of each bucket
+        std::vector<indexType> offset(T * B), start(B + 1);
+        indexType sum = 0;
+        for (indexType b = 0; b < B; b++) {
+            start[b] = sum;
+            for (unsigned t = 0; t < T; t++) { offset[t * B + b] = sum; sum += counts[t * B + b]; }
+        }
+        start[B] = N;
+        pollBudget(1);
+        pooled<Element> scratch(N);
+        parallel([&](unsigned t, indexType lo, indexType hi) {
+            for (indexType i = lo; i < hi; i++)
+                scratch[offset[t * B + bucketOf[i]]++] = arr[i];
+            Counting::count(workers[t]->bytesMoved, (hi - lo) * sizeof(Element));
+        });
+        pollBudget(1);
+        std::atomic<indexType> nextBucket(0);
+        parallel([&](unsigned t, indexType, indexType) {
+            basicSortFunctor &w = *workers[t];
+            for (indexType b = nextBucket++; b < B; b = nextBucket++) {
+                indexType n = start[b + 1] - start[b];
+                w.introSort(scratch.data() + start[b], n);
+                std::copy(scratch.data() + start[b], scratch.data() + start[b + 1], arr + start[b]);
+                Counting::count(w.bytesMoved, n * sizeof(Element));
+            }
+        });
+        for (auto &w : workers) {
+            exchanges   += w->exchanges;
+            comparisons += w->comparisons;
+            bytesMoved  += w->bytesMoved;
+            merges      += w->merges;
+            gallops     += w->gallops;
+        }
+    } // void sampleSort
+
+    // quickselect on introsort's pivots and partitions, following only the
+    // side which holds the k-th smallest key.  once the depth budget runs out
+    // the range left is finished with the heap selection, so it stays
+    // O(n log k) even on inputs which defeat the pivots.
+    void introSelect(Element *arr, indexType N) {
+        indexType k = selectRank(N);
+        if (k == 0) return;
+        indexType target = k - 1, lo = 0, hi = N;
+        int depth = 2 * log2floor(N);
+        while (hi - lo > INSERTION) {
+            pollBudget(1);
+            if (depth-- == 0) {
+                heapSelect(arr + lo, hi - lo, target - lo + 1);
+                return;
+            }
+            choosePivot(arr, lo, hi);
+            indexType p;
+            // as in introSplit, a pivot no bigger than the key before the
+            // range is the smallest key, so split off the keys equal to it
+            if (lo > 0 && !lessThan(arr[lo - 1], arr[lo])) {
+                p = partitionLeft(arr, lo, hi);
+                if (target <= p) return;
+                lo = p + 1;
+                continue;
+            }
+            bool alreadyPartitioned;
+            p = partitionRight(arr, lo, hi, alreadyPartitioned);
+            if (target == p) return;
+            if (target < p) hi = p;
+            else lo = p + 1;
+        }
+        insertionSort(arr, lo, hi);
+    } // void introSelect
+
+    // floyd and rivest's SELECT: before partitioning a big range it recurses on
+    // a small sample around where the k-th key should be, which leaves a
+    // pivot very close to it at index k, so each partition discards nearly
+    // everything on the wrong side.  it averages n + min(k, n - k) comparisons.
+    void floydRivest(Element *arr, indexType N) {
+        indexType k = selectRank(N);
+        if (k == 0) return;
+        floydRivestSplit(arr, 0, N - 1, k - 1);
+    }
+
+    // the k smallest keys, in order, using a max-heap of the best k so far:
+    // each remaining key which beats the heap's top replaces it
+    void heapTopK(Element *arr, indexType N) {
+        heapSelect(arr, N, selectRank(N));
+    }
+
+    // stable, run-adaptive merge sort in the style of timsort.  it finds the
+    // natural runs, reversing strictly descending ones, and extends short ones
+    // to a minimum length with binary insertion sort.  runs go on a stack that
+    // is merged whenever its lengths stop shrinking like the fibonacci numbers,
+    // so merges stay balanced.  a merge first gallops to skip the ends of the
+    // runs which are already in place, and switches from comparing one pair at
+    // a time to galloping whenever one run keeps winning.  all of the merges
+    // share mergeBuffer, which only ever grows.
+    void mergeSort(Element *arr, indexType N) {
+        if (N < 2) return;
+        if (N < MINMERGE) {
+            binaryInsertionSort(arr, 0, N, countRun(arr, 0, N));
+            return;
+        }
+        minGallop = MINGALLOP;
+        indexType minRun = minRunLength(N);
+        std::vector<mergeRun> runs;
+        for (indexType lo = 0; lo < N; ) {
+            pollBudget(POLLEVERY);
+            indexType n = countRun(arr, lo, N);
+            if (n < minRun) {
+                indexType forced = std::min(minRun, N - lo);
+                binaryInsertionSort(arr, lo, lo + forced, lo + n);
+                n = forced;
+            }
+            runs.push_back({lo, n});
+            mergeCollapse(arr, runs);
+            lo += n;
+        }
+        while (runs.size() > 1) {
+            pollBudget(1);
+            size_t i = runs.size() - 2;
+            if (i > 0 && runs[i - 1].length < runs[i + 1].length) i--;
+            mergeAt(arr, runs, i);
+        }
+    } // void mergeSort
+
+    // samples the input and hands it to the engine which did best on inputs
+    // that look like it in the sweeps at 1M keys:
+    //     sorted         checked with one pass and left alone
+    //     long runs      (reverse, organ pipe, sawtooth, sorted runs) mergesort
+    //     nearly sorted  blockquicksort, whose partitions leave presorted
+    //     or few keys    ranges and keys equal to the pivot behind at once
+    //     anything else  radix, if the array is big enough and its elements
+    //                    small enough to repay its passes, else blockquicksort
+    // the sampling is counted like any other work, and its time is kept in
+    // samplingTime for the ms_sampling column.
+    void autoSort(Element *arr, indexType N) {
+        Timer start = Clock::now();
+        sampled = samplePresortedness(arr, N);
+        Sorts chosen = Sorts::BLOCKQUICK;
+        bool sorted = sampled.runs < 2 && isSorted(arr, N);
+        if (sorted) dispatched = "none";
+        else {
+            if (sampled.runs < 2 || N / sampled.runs >= AUTORUN) chosen = Sorts::MERGE;
+            else if (sampled.distinct < AUTODISTINCT || sampled.inversions < AUTONEAR
+                     || sampled.inversions > 1 - AUTONEAR) chosen = Sorts::BLOCKQUICK;
+            else if (N >= AUTORADIX && sizeof(Element) <= AUTORECORD) chosen = Sorts::RADIX;
+            dispatched = sortNames[cast(chosen)];
+        }
+        samplingTime = Clock::now() - start;
+        if (!sorted) (*this.*engine(chosen))(arr, N);
+    } // void autoSort
+
+    // the standard library's sorts.  a counting functor runs them through
+    // countingIterator and countingLess, the bare twin on the plain array.
+    void stdSort(Element *arr, indexType N) {
+        if (Counting::counts) std::sort(countedBegin(arr), countedBegin(arr) + N, countedLess());
+        else std::sort(arr, arr + N, keyLess<Element>{&table});
+    }
+
+    void stdStableSort(Element *arr, indexType N) {
+        if (Counting::counts) std::stable_sort(countedBegin(arr), countedBegin(arr) + N, countedLess());
+        else std::stable_sort(arr, arr + N, keyLess<Element>{&table});
+    }
+
+    // the k smallest in order, at the front
+    void stdPartialSort(Element *arr, indexType N) {
+        indexType k = selectRank(N);
+        if (Counting::counts)
+            std::partial_sort(countedBegin(arr), countedBegin(arr) + k, countedBegin(arr) + N, countedLess());
+        else std::partial_sort(arr, arr + k, arr + N, keyLess<Element>{&table});
+    }
+
+    // the parallel algorithms may call the comparator from several threads at
+    // once, and par_unseq doesn't allow it to synchronize.  so the counted run
+    // uses the par policy with an atomic comparison count (the library runs
+    // the same parallel sort for both) and doesn't count moves; the bare twin
+    // runs par_unseq.  the library picks its own number of threads.
+    void stdParallelSort(Element *arr, indexType N) {
+#ifdef PARALLELSTL
+        if (Counting::counts) {
+            std::atomic<countType> compared(0);
+            const keyTable *keys = &table;
+            std::sort(std::execution::par, arr, arr + N, [&compared, keys](const Element &a, const Element &b) {
+                compared.fetch_add(1, std::memory_order_relaxed);
+                return elementKey(a, *keys) < elementKey(b, *keys);
+            });
+            Counting::count(comparisons, compared);
+        }
+        else std::sort(std::execution::par_unseq, arr, arr + N, keyLess<Element>{&table});
+#else
+        (void)arr; (void)N;
+        throw std::runtime_error(sortNames[cast(Sorts::STDPARALLEL)] + " needs C++17 and <execution>.");
+#endif
+    }
+
     private:
-    void exchange(sortType *arr, const indexType a, const indexType b) {
-        exchanges++;
-        sortType temp = arr[a];
+    // checks the deadline every so many calls, since reading the clock isn't free
+    void pollBudget(unsigned every) {
+        if (budgeted && ++polls % every == 0 && Clock::now() > deadline) throw overBudget();
+    }
+
+    countingIterator<Element> countedBegin(Element *arr) {
+        return countingIterator<Element>(arr, moveCounters{&exchanges, &bytesMoved});
+    }
+    countingLess<Element> countedLess() { return countingLess<Element>{&comparisons, &table}; }
+
+    // estimates the runs from the turns within AUTOSAMPLE / AUTOWINDOW
+    // windows of neighbours, the inversions from AUTOSAMPLE random pairs, and
+    // the distinct keys in a random sample of AUTOSAMPLE keys, by hashing
+    // them into a table twice that size, which copies no elements.  small
+    // arrays get samples no bigger than themselves, so sampling stays a
+    // fraction of the sort.
+    presortedness samplePresortedness(Element *arr, indexType N) {
+        presortedness p;
+        p.runs = p.distinct = 1;
+        if (N < 2) return p;
+        const indexType samples = std::min<indexType>(AUTOSAMPLE, N);
+        // scaling unit() avoids below()'s division, which would cost more
+        // than everything else the sampling does
+        auto pick = [this](indexType n) { return std::min(indexType(rd.unit() * n), n - 1); };
+        // a run ends where the keys turn from rising to falling or back,
+        // as merge sort finds them; equal neighbours don't turn
+        const indexType window = std::min<indexType>(AUTOWINDOW, N);
+        indexType pairs = 0, turns = 0;
+        for (indexType w = 0; w < std::max<indexType>(samples / window, 1); w++) {
+            indexType lo = pick(N - window + 1);
+            int direction = 0;
+            for (indexType i = lo + 1; i < lo + window; i++, pairs++) {
+                int step = compareTo(arr[i], arr[i - 1]);
+                if (step == 0) continue;
+                if (step == -direction) turns++;
+                direction = step;
+            }
+        }
+        p.runs = 1 + double(turns) / pairs * (N - 1);
+
+        indexType inverted = 0;
+        for (indexType s = 0; s < samples; s++) {
+            indexType i = pick(N), j = pick(N - 1);
+            if (j >= i) j++;
+            if (j < i) std::swap(i, j);
+            if (lessThan(arr[j], arr[i])) inverted++;
+        }
+        p.inversions = double(inverted) / samples;
+
+        static_assert((AUTOSAMPLE & (AUTOSAMPLE - 1)) == 0, "the distinct key table is a power of two");
+        const size_t slots = 2 * AUTOSAMPLE;
+        sortType seen[slots];
+        bool used[slots] = {};
+        indexType distinct = 0;
+        for (indexType s = 0; s < samples; s++) {
+            sortType key = keyOf(arr[pick(N)]);
+            size_t slot = splitmix64(key) & (slots - 1);
+            for (; used[slot]; slot = (slot + 1) & (slots - 1)) {
+                Counting::count(comparisons);
+                if (seen[slot] == key) break;
+            }
+            if (!used[slot]) {
+                used[slot] = true;
+                seen[slot] = key;
+                distinct++;
+            }
+        }
+        p.distinct = double(distinct) / samples;
+        return p;
+    } // presortedness samplePresortedness
+
+    bool isSorted(Element *arr, indexType N) {
+        for (indexType i = 1; i < N; i++)
+            if (lessThan(arr[i], arr[i - 1])) return false;
+        return true;
+    }
+
+    void exchange(Element *arr, const indexType a, const indexType b) {
+        Counting::count(exchanges);
+        Counting::count(bytesMoved, 2 * sizeof(Element));
+        Element temp = arr[a];
         arr[a] = arr[b];
         arr[b] = temp;
     }
 
     // compare two elements of same array
-    int compare(sortType *arr, const indexType a, const indexType b) {
-        comparisons++;
-        if (arr[a] > arr[b]) return 1;
-        else if (arr[a] < arr[b]) return -1;
+    int compare(Element *arr, const indexType a, const indexType b) {
+        Counting::count(comparisons);
+        if (keyOf(arr[a]) > keyOf(arr[b])) return 1;
+        else if (keyOf(arr[a]) < keyOf(arr[b])) return -1;
         else return 0;
     }
     // mimics java's compare
-    int compareTo(const sortType &a, const sortType &b) {
-        comparisons++;
-        if      (a < b) return -1;
-        else if (b < a) return 1;
+    int compareTo(const Element &a, const Element &b) {
+        Counting::count(comparisons);
+        if      (keyOf(a) < keyOf(b)) return -1;
+        else if (keyOf(b) < keyOf(a)) return 1;
         else            return 0;
     }
 
-    bool lessThan(sortType a, sortType b) { comparisons++; return a < b; }
-    bool greaterThan(sortType a, sortType b) {comparisons++; return a > b; }
+    bool lessThan(const Element &a, const Element &b) { Counting::count(comparisons); return keyOf(a) < keyOf(b); }
+    bool greaterThan(const Element &a, const Element &b) { Counting::count(comparisons); return keyOf(a) > keyOf(b); }
 
-    void heapSiftDown(sortType *arr, long k, long N) {
+    void heapSiftDown(Element *arr, long k, long N) {
         indexType right = 2 * (k + 1);
         indexType left = right - 1;
         indexType largest = k;
@@ -213,52 +1040,548 @@ struct sortFunctor {
         }
     }
 
-    void quickSplit(sortType *arr, long lo, long hi) {
-        if (hi <= lo) return;
-        int lt = lo, gt = hi;
-        indexType mid = lo + (hi - lo) / 2;
-        sortType v = arr[mid];
-        indexType i = lo;
-        while (i <= gt) {
-            int cmp = compareTo(arr[i], v);
-            if      (cmp < 0) exchange(arr, lt++, i++);
-            else if (cmp > 0) exchange(arr, i, gt--);
-            else i++;
+    sortType keyOf(const Element &e) const { return elementKey(e, table); }
+
+    // sorts a small range with a sorting network.  the network does every one
+    // of its comparators whatever the data, so they are all counted.  the
+    // networks only sort bare keys, anything else gets insertion sort.
+    void networkLeaf(Element *arr, indexType n) { networkLeaf(arr, n, std::is_same<Element, sortType>()); }
+    void networkLeaf(Element *arr, indexType n, std::true_type) {
+        size_t block = networkSort(reinterpret_cast<uint64_t *>(arr), n);
+        Counting::count(comparisons, networkComparators(block));
+        Counting::count(bytesMoved, 2 * n * sizeof(Element));
+    }
+    void networkLeaf(Element *arr, indexType n, std::false_type) { insertionSort(arr, 0, n); }
+
+    // children per d-ary heap node: as many as fill a cache line, but at
+    // least two for elements bigger than half a line
+    static constexpr indexType heapArity() {
+        return CACHELINE / sizeof(Element) > 2 ? CACHELINE / sizeof(Element) : 2;
+    }
+    static indexType dheapFirstChild(indexType h) { return h ? h * heapArity() : 1; }
+    static indexType dheapParent(indexType c)     { return c < heapArity() ? 0 : c / heapArity(); }
+
+    // Floyd's sift-down: walk the hole all the way down along the largest
+    // children, which costs d-1 comparisons a level instead of d, then sift the
+    // displaced key back up from the leaf, which is usually only a level or two
+    void dheapSiftDown(Element *arr, indexType top, indexType n) {
+        Element key = arr[top];
+        indexType hole = top;
+        for (indexType first = dheapFirstChild(hole); first < n; first = dheapFirstChild(hole)) {
+            indexType last = std::min<indexType>(first + heapArity(), n);
+#ifdef __GNUC__
+            for (indexType c = first; c < last && dheapFirstChild(c) < n; c++)
+                __builtin_prefetch(arr + dheapFirstChild(c));
+#endif
+            indexType largest = first;
+            for (indexType c = first + 1; c < last; c++)
+                if (lessThan(arr[largest], arr[c])) largest = c;
+            arr[hole] = arr[largest];
+            Counting::count(bytesMoved, sizeof(Element));
+            hole = largest;
+        }
+        while (hole > top && lessThan(arr[dheapParent(hole)], key)) {
+            arr[hole] = arr[dheapParent(hole)];
+            Counting::count(bytesMoved, sizeof(Element));
+            hole = dheapParent(hole);
+        }
+        arr[hole] = key;
+    } // void dheapSiftDown
+
+    void heapSelect(Element *arr, indexType n, indexType k) {
+        if (k == 0) return;
+        for (long i = k >> 1; i >= 0; i--) {
+            pollBudget(POLLEVERY);
+            heapSiftDown(arr, i, k);
+        }
+        for (indexType i = k; i < n; i++) {
+            pollBudget(POLLEVERY);
+            if (lessThan(arr[i], arr[0])) {
+                exchange(arr, 0, i);
+                heapSiftDown(arr, 0, k);
+            }
+        }
+        for (indexType end = k - 1; end > 0; end--) {
+            pollBudget(POLLEVERY);
+            exchange(arr, 0, end);
+            heapSiftDown(arr, 0, end);
+        }
+    }
+
+    // puts the target-th key of [left, right] in place
+    void floydRivestSplit(Element *arr, long left, long right, long target) {
+        while (right > left) {
+            pollBudget(1);
+            if (right - left > SELECTSAMPLE) {
+                double n = right - left + 1, i = target - left + 1, z = std::log(n);
+                double s = 0.5 * std::exp(2 * z / 3);
+                double sd = 0.5 * std::sqrt(z * s * (n - s) / n) * (i < n / 2 ? -1 : 1);
+                long newLeft  = std::max(left, long(target - i * s / n + sd));
+                long newRight = std::min(right, long(target + (n - i) * s / n + sd));
+                floydRivestSplit(arr, newLeft, newRight, target);
+            }
+            // partition [left, right] around t = arr[target], with t parked at
+            // one end so it can be swapped into the middle afterwards
+            Element t = arr[target];
+            long i = left, j = right;
+            exchange(arr, left, target);
+            if (lessThan(t, arr[right])) exchange(arr, right, left);
+            while (i < j) {
+                exchange(arr, i++, j--);
+                while (lessThan(arr[i], t)) i++;
+                while (lessThan(t, arr[j])) j--;
+            }
+            if (compareTo(arr[left], t) == 0) exchange(arr, left, j);
+            else exchange(arr, ++j, right);
+            if (j <= target) left = j + 1;
+            if (target <= j) right = j - 1;
+        }
+    } // void floydRivestSplit
+
+    // recurses into the smaller side and loops on the larger, so the stack
+    // stays O(log N) deep even when the middle pivot is a poor one (organ pipe)
+    void quickSplit(Element *arr, long lo, long hi) {
+        while (hi - lo >= NETWORK) {
+            pollBudget(POLLEVERY);
+            long lt = lo, gt = hi;
+            long mid = lo + (hi - lo) / 2;
+            Element v = arr[mid];
+            long i = lo;
+            while (i <= gt) {
+                int cmp = compareTo(arr[i], v);
+                if      (cmp < 0) exchange(arr, lt++, i++);
+                else if (cmp > 0) exchange(arr, i, gt--);
+                else i++;
 
+            }
+            if (lt - lo < hi - gt) {
+                quickSplit(arr, lo, lt - 1);
+                lo = gt + 1;
+            } else {
+                quickSplit(arr, gt + 1, hi);
+                hi = lt - 1;
+            }
         }
-        quickSplit(arr, lo, lt - 1);
-        quickSplit(arr, gt + 1, hi);
+        if (hi > lo) networkLeaf(arr + lo, hi - lo + 1);
     } // void quickSplit
 
-    // generate the initial sets
-    // forward and reverse are trivial.
-    // the "almost" routines generate the initial, and then swap a certain number
-    // of random places
-    // the uniform random uses c++11's list shuffle routine
-    void generateInput(sortType *arr, indexType N, Orders order) {
-        if (verbose) std::cout << orderNames[cast(order)] << "... ";
-        switch(order) {
-            case Orders::FORWARD:
-                for (indexType i = 0; i < N; i++) arr[i] = i + 1;
-                break;
-            case Orders::ALMOSTFORWARD:
-                for (indexType i = 0; i < N; i++) arr[i] = i + 1;
-                for (int i = N / ALMOST; i >= 0; i--)
-                    exchange(arr, dist(rd), dist(rd));
-                break;
-            case Orders::REVERSE:
-                for (indexType i = 0; i < N; i++) arr[i] = N - i;
-                break;
-            case Orders::ALMOSTREVERSE:
-                for (indexType i = 0; i < N; i++) arr[i] = N - i;
-                for (int i = N / ALMOST; i >= 0; i--)
-                    exchange(arr, dist(rd), dist(rd));
-                break;
-            case Orders::UNIFORM:
-                for (indexType i = 0; i < N; i++) arr[i] = N - i;
-                std::random_shuffle(arr, arr + N); 
-                break;
-        }
-    } // void generateInput
-}; // struct sortFunctor
+    // index of the first splitter greater than key
+    indexType findBucket(const std::vector<Element> &splitters, const Element &key) {
+        indexType lo = 0, hi = splitters.size();
+        while (lo < hi) {
+            indexType mid = lo + (hi - lo) / 2;
+            if (lessThan(key, splitters[mid])) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo;
+    }
+
+    static int digitOf(sortType key, int d) { return (key >> (8 * d)) & (BUCKETS - 1); }
+
+    // how many digits an MSD sort needs before buckets of N keys get small
+    static int msdLevels(indexType n) {
+        int levels = 1;
+        while (n >>= 8) levels++;
+        return levels;
+    }
+
+    // most significant digit first on [lo, hi), scattering through scratch.
+    // small buckets are finished with insertion sort.
+    void msdSplit(Element *arr, Element *scratch, indexType lo, indexType hi, int d) {
+        indexType n = hi - lo;
+        if (n <= INSERTION) {
+            insertionSort(arr, lo, hi);
+            return;
+        }
+        pollBudget(POLLEVERY);
+        indexType start[BUCKETS + 1];
+        for (;;) {
+            std::fill(start, start + BUCKETS + 1, 0);
+            for (indexType i = lo; i < hi; i++) start[digitOf(keyOf(arr[i]), d) + 1]++;
+            if (start[digitOf(keyOf(arr[lo]), d) + 1] != n) break;
+            // every key shares this digit, go straight to the next one
+            if (d-- == 0) return;
+        }
+        for (int b = 0; b < BUCKETS; b++) start[b + 1] += start[b];
+        indexType next[BUCKETS];
+        std::copy(start, start + BUCKETS, next);
+        for (indexType i = lo; i < hi; i++)
+            scratch[lo + next[digitOf(keyOf(arr[i]), d)]++] = arr[i];
+        std::copy(scratch + lo, scratch + hi, arr + lo);
+        Counting::count(bytesMoved, 2 * n * sizeof(Element));
+        if (d == 0) return;
+        for (int b = 0; b < BUCKETS; b++)
+            if (start[b + 1] - start[b] > 1)
+                msdSplit(arr, scratch, lo + start[b], lo + start[b + 1], d - 1);
+    } // void msdSplit
+
+    struct mergeRun { indexType base, length; };
+
+    // timsort's minimum run: N shifted down to between MINMERGE/2 and
+    // MINMERGE, plus one if any bit shifted out was set, so N / minRun is a
+    // power of two or just under one and the final merges are balanced
+    static indexType minRunLength(indexType n) {
+        indexType odd = 0;
+        while (n >= MINMERGE) { odd |= n & 1; n >>= 1; }
+        return n + odd;
+    }
+
+    // length of the run starting at lo.  a strictly descending run is
+    // reversed in place; it has to be strict or reversing it wouldn't be stable
+    indexType countRun(Element *arr, indexType lo, indexType hi) {
+        indexType end = lo + 1;
+        if (end == hi) return 1;
+        if (lessThan(arr[end++], arr[lo])) {
+            while (end < hi && lessThan(arr[end], arr[end - 1])) end++;
+            std::reverse(arr + lo, arr + end);
+            Counting::count(bytesMoved, 2 * ((end - lo) / 2) * sizeof(Element));
+        } else {
+            while (end < hi && !lessThan(arr[end], arr[end - 1])) end++;
+        }
+        return end - lo;
+    }
+
+    // sorts [lo, hi) given that [lo, start) is already sorted, finding each
+    // key's place with a binary search and shifting the keys after it up.
+    // equal keys go after the ones already placed, which keeps it stable.
+    void binaryInsertionSort(Element *arr, indexType lo, indexType hi, indexType start) {
+        for (indexType i = start; i < hi; i++) {
+            Element key = arr[i];
+            indexType left = lo, right = i;
+            while (left < right) {
+                indexType mid = left + (right - left) / 2;
+                if (lessThan(key, arr[mid])) right = mid;
+                else left = mid + 1;
+            }
+            std::copy_backward(arr + left, arr + i, arr + i + 1);
+            arr[left] = key;
+            Counting::count(bytesMoved, (i - left + 1) * sizeof(Element));
+        }
+    }
+
+    // merge until, reading down from the top of the stack, each run is longer
+    // than the two above it together and longer than the one above it
+    void mergeCollapse(Element *arr, std::vector<mergeRun> &runs) {
+        while (runs.size() > 1) {
+            size_t i = runs.size() - 2;
+            if ((i > 0 && runs[i - 1].length <= runs[i].length + runs[i + 1].length)
+             || (i > 1 && runs[i - 2].length <= runs[i - 1].length + runs[i].length)) {
+                if (runs[i - 1].length < runs[i + 1].length) i--;
+            } else if (runs[i].length > runs[i + 1].length) break;
+            mergeAt(arr, runs, i);
+        }
+    }
+
+    // merges runs i and i + 1 of the stack.  the keys of the first run which
+    // aren't greater than the second run's first key, and the keys of the
+    // second run which aren't less than the first run's last key, are already
+    // in place, so only what is left between them goes through the buffer
+    void mergeAt(Element *arr, std::vector<mergeRun> &runs, size_t i) {
+        Counting::count(merges);
+        Element *a = arr + runs[i].base, *b = arr + runs[i + 1].base;
+        indexType n1 = runs[i].length, n2 = runs[i + 1].length;
+        runs[i].length = n1 + n2;
+        runs.erase(runs.begin() + i + 1);
+        indexType skip = gallop(b[0], a, n1, true, false);
+        a += skip;
+        n1 -= skip;
+        if (n1 == 0) return;
+        n2 = gallop(a[n1 - 1], b, n2, false, true);
+        if (n2 == 0) return;
+        if (n1 <= n2) mergeLow(a, n1, b, n2);
+        else mergeHigh(a, n1, b, n2);
+    }
+
+    // the number of keys in the sorted base[0, n) which go before key: those
+    // less than it, or for right those not greater than it, so equal keys
+    // land after them.  the search probes 1, 2, 4 ... keys in from the start,
+    // or from the end, then binary searches the last gap, which costs about
+    // 2 log k comparisons for an answer k keys from where it started.
+    indexType gallop(const Element &key, const Element *base, indexType n, bool right, bool fromEnd) {
+        Counting::count(gallops);
+        auto before = [&](const Element &x) { return right ? !lessThan(key, x) : lessThan(x, key); };
+        indexType lo = 0, hi = n;
+        for (indexType reach = 1; reach <= n; reach *= 2) {
+            indexType i = fromEnd ? n - reach : reach - 1;
+            if (before(base[i])) { lo = i + 1; if (fromEnd) break; }
+            else                 { hi = i;     if (!fromEnd) break; }
+        }
+        while (lo < hi) {
+            indexType mid = lo + (hi - lo) / 2;
+            if (before(base[mid])) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // copy n keys forwards or backwards, counting the bytes
+    void moveKeys(const Element *from, indexType n, Element *to) {
+        std::copy(from, from + n, to);
+        Counting::count(bytesMoved, n * sizeof(Element));
+    }
+    void moveKeysBackward(const Element *from, indexType n, Element *toEnd) {
+        std::copy_backward(from, from + n, toEnd);
+        Counting::count(bytesMoved, n * sizeof(Element));
+    }
+
+    Element *mergeScratch(indexType n) {
+        if (mergeBuffer.size() < n) mergeBuffer = pooled<Element>(std::max<indexType>(n, 2 * mergeBuffer.size()));
+        return mergeBuffer.data();
+    }
+
+    // merges the adjacent runs a[0, n1) and b[0, n2) when the first is the
+    // shorter: it goes into the buffer and the merge fills in from the left.
+    // mergeAt leaves b[0] < a[0] and a's last key greater than all of b, so
+    // once a is down to one key the rest of b goes before it.
+    void mergeLow(Element *a, indexType n1, Element *b, indexType n2) {
+        Element *x = mergeScratch(n1), *y = b, *dest = a;
+        moveKeys(a, n1, x);
+        while (n1 > 1 && n2 > 0) {
+            // one pair at a time, until a run wins minGallop times in a row
+            indexType wins1 = 0, wins2 = 0;
+            while (n1 > 1 && n2 > 0 && std::max(wins1, wins2) < indexType(minGallop)) {
+                if (lessThan(*y, *x)) { *dest++ = *y++; n2--; wins2++; wins1 = 0; }
+                else                  { *dest++ = *x++; n1--; wins1++; wins2 = 0; }
+                Counting::count(bytesMoved, sizeof(Element));
+            }
+            // then gallop, for as long as galloping finds long stretches
+            while (n1 > 1 && n2 > 0) {
+                wins1 = gallop(*y, x, n1, true, false);
+                moveKeys(x, wins1, dest);
+                dest += wins1; x += wins1; n1 -= wins1;
+                if (n1 <= 1) break;
+                moveKeys(y++, 1, dest++);
+                if (--n2 == 0) break;
+                wins2 = gallop(*x, y, n2, false, false);
+                moveKeys(y, wins2, dest);
+                dest += wins2; y += wins2; n2 -= wins2;
+                if (n2 == 0) break;
+                moveKeys(x++, 1, dest++);
+                if (--n1 == 1) break;
+                if (wins1 < MINGALLOP && wins2 < MINGALLOP) {
+                    minGallop += 2;     // galloping didn't pay, make it harder to start again
+                    break;
+                }
+                if (minGallop > 1) minGallop--;
+            }
+        }
+        if (n2 == 0) moveKeys(x, n1, dest);
+        else {
+            moveKeys(y, n2, dest);
+            moveKeys(x, 1, dest + n2);
+        }
+    } // void mergeLow
+
+    // the mirror image of mergeLow for when the second run is the shorter: it
+    // goes into the buffer and the merge fills in from the right.  once b is
+    // down to its first key, which is the smallest of all, the rest of a goes
+    // after it.
+    void mergeHigh(Element *a, indexType n1, Element *b, indexType n2) {
+        Element *buffer = mergeScratch(n2);
+        moveKeys(b, n2, buffer);
+        // x, y and dest point one past the next key to move
+        Element *x = a + n1, *y = buffer + n2, *dest = b + n2;
+        while (n2 > 1 && n1 > 0) {
+            indexType wins1 = 0, wins2 = 0;
+            while (n2 > 1 && n1 > 0 && std::max(wins1, wins2) < indexType(minGallop)) {
+                if (lessThan(y[-1], x[-1])) { *--dest = *--x; n1--; wins1++; wins2 = 0; }
+                else                        { *--dest = *--y; n2--; wins2++; wins1 = 0; }
+                Counting::count(bytesMoved, sizeof(Element));
+            }
+            while (n2 > 1 && n1 > 0) {
+                wins1 = n1 - gallop(y[-1], a, n1, true, true);
+                x -= wins1; dest -= wins1; n1 -= wins1;
+                moveKeysBackward(x, wins1, dest + wins1);
+                if (n1 == 0) break;
+                moveKeys(--y, 1, --dest);
+                if (--n2 == 1) break;
+                wins2 = n2 - gallop(x[-1], buffer, n2, false, true);
+                y -= wins2; dest -= wins2; n2 -= wins2;
+                moveKeys(y, wins2, dest);
+                if (n2 <= 1) break;
+                moveKeys(--x, 1, --dest);
+                if (--n1 == 0) break;
+                if (wins1 < MINGALLOP && wins2 < MINGALLOP) {
+                    minGallop += 2;
+                    break;
+                }
+                if (minGallop > 1) minGallop--;
+            }
+        }
+        if (n1 == 0) moveKeys(buffer, n2, a);
+        else {
+            moveKeysBackward(a, n1, dest);
+            moveKeys(buffer, 1, a);
+        }
+    } // void mergeHigh
+
+    static int log2floor(indexType n) {
+        int log = 0;
+        while (n >>= 1) log++;
+        return log;
+    }
+
+    // sorts [lo, hi).  ranges which are already partitioned get a cheap
+    // insertion sort attempt, runs of keys equal to the element before the
+    // range are skipped in one pass, and once depth runs out the rest of the
+    // range is heapsorted so the worst case stays O(n log n).  branchless
+    // picks the block partition.
+    void introSplit(Element *arr, indexType lo, indexType hi, int depth, bool branchless = false) {
+        while (hi - lo > INSERTION) {
+            pollBudget(POLLEVERY);
+            if (depth-- == 0) {
+                heapSort(arr + lo, hi - lo);
+                return;
+            }
+            choosePivot(arr, lo, hi);
+            // everything left of lo is <= the whole range, so if it is also
+            // >= the pivot then the pivot is the smallest key in the range
+            if (lo > 0 && !lessThan(arr[lo - 1], arr[lo])) {
+                lo = partitionLeft(arr, lo, hi) + 1;
+                continue;
+            }
+            bool alreadyPartitioned;
+            indexType p = branchless ? partitionBlock(arr, lo, hi, alreadyPartitioned)
+                                     : partitionRight(arr, lo, hi, alreadyPartitioned);
+            if (alreadyPartitioned && partialInsertionSort(arr, lo, p)
+                                   && partialInsertionSort(arr, p + 1, hi))
+                return;
+            // recurse into the smaller side, loop on the larger
+            if (p - lo < hi - p) {
+                introSplit(arr, lo, p, depth, branchless);
+                lo = p + 1;
+            } else {
+                introSplit(arr, p + 1, hi, depth, branchless);
+                hi = p;
+            }
+        }
+        insertionSort(arr, lo, hi);
+    } // void introSplit
+
+    // order arr[a] <= arr[b] <= arr[c]
+    void sort3(Element *arr, indexType a, indexType b, indexType c) {
+        if (compare(arr, a, b) > 0) exchange(arr, a, b);
+        if (compare(arr, b, c) > 0) exchange(arr, b, c);
+        if (compare(arr, a, b) > 0) exchange(arr, a, b);
+    }
+
+    // leaves the median of 3 (or the ninther for large ranges) at arr[lo]
+    void choosePivot(Element *arr, indexType lo, indexType hi) {
+        indexType n = hi - lo, mid = lo + n / 2;
+        if (n > NINTHER) {
+            sort3(arr, lo, mid, hi - 1);
+            sort3(arr, lo + 1, mid - 1, hi - 2);
+            sort3(arr, lo + 2, mid + 1, hi - 3);
+            sort3(arr, mid - 1, mid, mid + 1);
+            exchange(arr, lo, mid);
+        } else sort3(arr, mid, lo, hi - 1);
+    }
+
+    // partitions [lo, hi) around the pivot at arr[lo] into keys < pivot and
+    // keys >= pivot, and returns the pivot's final position.  reports whether
+    // no exchanges were needed, which is a hint the range is already sorted.
+    indexType partitionRight(Element *arr, indexType lo, indexType hi, bool &alreadyPartitioned) {
+        Element pivot = arr[lo];
+        indexType i = lo + 1, j = hi - 1;
+        while (i <= j && lessThan(arr[i], pivot)) i++;
+        while (i <= j && !lessThan(arr[j], pivot)) j--;
+        alreadyPartitioned = i > j;
+        while (i < j) {
+            exchange(arr, i++, j--);
+            while (i <= j && lessThan(arr[i], pivot)) i++;
+            while (i <= j && !lessThan(arr[j], pivot)) j--;
+        }
+        if (i - 1 != lo) exchange(arr, lo, i - 1);
+        return i - 1;
+    }
+
+    // partitionRight's contract, with the unknown middle of the range
+    // classified a block at a time from both ends.  each block fills a list
+    // of the offsets of keys on the wrong side, by adding the comparison's
+    // result to the list's length rather than branching on it; then as many
+    // pairs as both lists have are swapped, and a side whose list is used up
+    // classifies its next block.  the last blocks may be shorter, and keys
+    // still listed when the middle is used up are swapped to the boundary.
+    indexType partitionBlock(Element *arr, indexType lo, indexType hi, bool &alreadyPartitioned) {
+        const Element pivot = arr[lo];
+        indexType first = lo + 1, last = hi;
+        while (first < last && lessThan(arr[first], pivot)) first++;
+        while (first < last && !lessThan(arr[last - 1], pivot)) last--;
+        alreadyPartitioned = first >= last;
+        if (!alreadyPartitioned) {
+            exchange(arr, first++, --last);
+            alignas(CACHELINE) unsigned char offsetsLeft[PARTITIONBLOCK];
+            alignas(CACHELINE) unsigned char offsetsRight[PARTITIONBLOCK];
+            // left offsets count up from baseLeft, right offsets down from baseRight
+            indexType baseLeft = first, baseRight = last;
+            indexType numLeft = 0, numRight = 0, startLeft = 0, startRight = 0;
+            while (first < last) {
+                indexType unknown = last - first;
+                indexType leftSplit  = numLeft == 0 ? (numRight == 0 ? unknown / 2 : unknown) : 0;
+                indexType rightSplit = numRight == 0 ? unknown - leftSplit : 0;
+                leftSplit  = std::min<indexType>(leftSplit, PARTITIONBLOCK);
+                rightSplit = std::min<indexType>(rightSplit, PARTITIONBLOCK);
+                for (indexType i = 0; i < leftSplit; i++) {
+                    offsetsLeft[numLeft] = i;
+                    numLeft += !lessThan(arr[first++], pivot);
+                }
+                for (indexType i = 0; i < rightSplit; ) {
+                    offsetsRight[numRight] = ++i;
+                    numRight += lessThan(arr[--last], pivot);
+                }
+                indexType pairs = std::min(numLeft, numRight);
+                for (indexType j = 0; j < pairs; j++)
+                    exchange(arr, baseLeft + offsetsLeft[startLeft + j], baseRight - offsetsRight[startRight + j]);
+                numLeft -= pairs;   startLeft += pairs;
+                numRight -= pairs;  startRight += pairs;
+                if (numLeft == 0)  { startLeft = 0;  baseLeft = first; }
+                if (numRight == 0) { startRight = 0; baseRight = last; }
+            }
+            if (numLeft) {
+                while (numLeft > 0) exchange(arr, baseLeft + offsetsLeft[startLeft + --numLeft], --last);
+                first = last;
+            }
+            if (numRight) {
+                while (numRight > 0) exchange(arr, baseRight - offsetsRight[startRight + --numRight], first++);
+                last = first;
+            }
+        }
+        if (first - 1 != lo) exchange(arr, lo, first - 1);
+        return first - 1;
+    } // indexType partitionBlock
+
+    // as above but splits into keys <= pivot and keys > pivot.  only used
+    // when the pivot is the smallest key, so the left side is all equal keys.
+    indexType partitionLeft(Element *arr, indexType lo, indexType hi) {
+        Element pivot = arr[lo];
+        indexType i = lo + 1, j = hi - 1;
+        while (i <= j && !lessThan(pivot, arr[i])) i++;
+        while (i <= j && lessThan(pivot, arr[j])) j--;
+        while (i < j) {
+            exchange(arr, i++, j--);
+            while (i <= j && !lessThan(pivot, arr[i])) i++;
+            while (i <= j && lessThan(pivot, arr[j])) j--;
+        }
+        if (i - 1 != lo) exchange(arr, lo, i - 1);
+        return i - 1;
+    }
+
+    void insertionSort(Element *arr, indexType lo, indexType hi) {
+        for (indexType i = lo + 1; i < hi; i++)
+            for (indexType j = i; j > lo && lessThan(arr[j], arr[j - 1]); j--)
+                exchange(arr, j, j - 1);
+    }
+
+    // insertion sort which gives up after PARTIAL element moves
+    bool partialInsertionSort(Element *arr, indexType lo, indexType hi) {
+        indexType moves = 0;
+        for (indexType i = lo + 1; i < hi; i++) {
+            for (indexType j = i; j > lo && lessThan(arr[j], arr[j - 1]); j--) {
+                exchange(arr, j, j - 1);
+                if (++moves > PARTIAL) return false;
+            }
+        }
+        return true;
+    }
+}; // struct basicSortFunctor
 #endif
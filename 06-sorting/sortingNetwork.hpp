@@ -0,0 +1,165 @@
+//////////////////////////////////////////////////////////////////////////////////
+// sortingNetwork.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// bitonic sorting networks for blocks of 8, 16 or 32 64-bit keys, used as the
+// leaf case of the recursive sorts.  a network does the same fixed sequence of
+// compare-exchanges whatever the data looks like, so it has no branches to
+// mispredict and maps directly onto vector min/max.
+//
+// the vector version is picked at compile time:
+//     AVX2      4 keys per register    (compile with -mavx2 or -march=native)
+//     SSE4.2    2 keys per register    (compile with -msse4.2)
+//     otherwise the scalar network below
+// the vector units only have a signed 64-bit compare, so keys are biased by
+// flipping the sign bit on load and flipping it back on store.
+//
+// the network is Batcher's bitonic sort: for each merge size k, for each
+// stride j, element i is compare-exchanged with i ^ j, ascending when bit k of
+// i is clear.  strides of a whole register or more compare register against
+// register; the two (or one) strides inside a register use a lane shuffle.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __sortingNetwork__
+#define __sortingNetwork__
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+#define NETWORK 32     // largest block the networks sort
+
+// the compare-exchanges a bitonic network of n keys performs
+static constexpr size_t networkComparators(size_t n) {
+    return n == 8 ? 24 : n == 16 ? 80 : n == 32 ? 240 : 0;
+}
+
+// smallest network block that holds n keys
+static inline size_t networkBlock(size_t n) {
+    return n <= 8 ? 8 : n <= 16 ? 16 : 32;
+}
+
+// plain c++ version of the network, the baseline for the vector ones.  each
+// compare-exchange is a min and a max, which compile to conditional moves (or
+// min/max instructions), so like the vector versions it doesn't branch on the
+// keys; the only branches left are on the indexes.
+template <size_t n>
+void bitonicSortScalar(uint64_t *a) {
+    for (size_t k = 2; k <= n; k <<= 1)
+        for (size_t j = k >> 1; j > 0; j >>= 1)
+            for (size_t i = 0; i < n; i++) {
+                size_t partner = i ^ j;
+                if (partner < i) continue;
+                bool up = (i & k) == 0;
+                uint64_t x = a[i], y = a[partner];
+                uint64_t mn = y < x ? y : x, mx = y < x ? x : y;
+                a[i]       = up ? mn : mx;
+                a[partner] = up ? mx : mn;
+            }
+}
+
+#if defined(__AVX2__)
+#define NETWORK_ISA "avx2"
+template <size_t n>
+void bitonicSort(uint64_t *a) {
+    static_assert(n % 4 == 0, "block must fill whole registers");
+    const size_t L = 4;
+    const __m256i bias = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+    __m256i r[n / L];
+    for (size_t v = 0; v < n / L; v++)
+        r[v] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + v * L)), bias);
+    for (size_t k = 2; k <= n; k <<= 1)
+        for (size_t j = k >> 1; j > 0; j >>= 1) {
+            for (size_t v = 0; v < n / L; v++) {
+                size_t i = v * L;
+                __m256i x = r[v], y;
+                if (j >= L) {
+                    size_t w = (i ^ j) / L;
+                    if (w < v) continue;
+                    y = r[w];
+                } else if (j == 2) y = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 3, 2));
+                else               y = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 3, 0, 1));
+                __m256i gt = _mm256_cmpgt_epi64(x, y);
+                __m256i mn = _mm256_blendv_epi8(x, y, gt);
+                __m256i mx = _mm256_blendv_epi8(y, x, gt);
+                if (j >= L) {
+                    bool up = (i & k) == 0;
+                    r[v]           = up ? mn : mx;
+                    r[(i ^ j) / L] = up ? mx : mn;
+                } else {
+                    // a lane keeps the max when it is the upper half of an
+                    // ascending pair or the lower half of a descending one
+                    int64_t keep[L];
+                    for (size_t l = 0; l < L; l++)
+                        keep[l] = (((i + l) & j) != 0) == (((i + l) & k) == 0) ? -1 : 0;
+                    __m256i mask = _mm256_set_epi64x(keep[3], keep[2], keep[1], keep[0]);
+                    r[v] = _mm256_blendv_epi8(mn, mx, mask);
+                }
+            }
+        }
+    for (size_t v = 0; v < n / L; v++)
+        _mm256_storeu_si256((__m256i *)(a + v * L), _mm256_xor_si256(r[v], bias));
+}
+#elif defined(__SSE4_2__)
+#define NETWORK_ISA "sse4.2"
+template <size_t n>
+void bitonicSort(uint64_t *a) {
+    static_assert(n % 2 == 0, "block must fill whole registers");
+    const size_t L = 2;
+    const __m128i bias = _mm_set1_epi64x(std::numeric_limits<int64_t>::min());
+    __m128i r[n / L];
+    for (size_t v = 0; v < n / L; v++)
+        r[v] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + v * L)), bias);
+    for (size_t k = 2; k <= n; k <<= 1)
+        for (size_t j = k >> 1; j > 0; j >>= 1) {
+            for (size_t v = 0; v < n / L; v++) {
+                size_t i = v * L;
+                __m128i x = r[v], y;
+                if (j >= L) {
+                    size_t w = (i ^ j) / L;
+                    if (w < v) continue;
+                    y = r[w];
+                } else y = _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2));
+                __m128i gt = _mm_cmpgt_epi64(x, y);
+                __m128i mn = _mm_blendv_epi8(x, y, gt);
+                __m128i mx = _mm_blendv_epi8(y, x, gt);
+                if (j >= L) {
+                    bool up = (i & k) == 0;
+                    r[v]           = up ? mn : mx;
+                    r[(i ^ j) / L] = up ? mx : mn;
+                } else {
+                    // within a register only the stride 1 pair is left, and
+                    // the upper lane of an ascending pair keeps the max
+                    bool up = (i & k) == 0;
+                    r[v] = up ? _mm_blend_epi16(mn, mx, 0xF0) : _mm_blend_epi16(mx, mn, 0xF0);
+                }
+            }
+        }
+    for (size_t v = 0; v < n / L; v++)
+        _mm_storeu_si128((__m128i *)(a + v * L), _mm_xor_si128(r[v], bias));
+}
+#else
+#define NETWORK_ISA "scalar"
+template <size_t n>
+void bitonicSort(uint64_t *a) { bitonicSortScalar<n>(a); }
+#endif
+
+// sort n <= NETWORK keys with the smallest network that holds them, padding
+// the block with the largest key.  returns the block size that was used.
+static inline size_t networkSort(uint64_t *a, size_t n) {
+    uint64_t block[NETWORK];
+    size_t size = networkBlock(n);
+    std::copy(a, a + n, block);
+    std::fill(block + n, block + size, std::numeric_limits<uint64_t>::max());
+    switch (size) {
+        case 8:  bitonicSort<8>(block);  break;
+        case 16: bitonicSort<16>(block); break;
+        default: bitonicSort<32>(block); break;
+    }
+    std::copy(block, block + n, a);
+    return size;
+}
+#endif
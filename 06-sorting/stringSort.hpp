@@ -0,0 +1,454 @@
+//////////////////////////////////////////////////////////////////////////////////
+// stringSort.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// sorting string keys, like the customer and item names of assignment #1.
+// the strings live in one arena and the engines sort pointers to them, so a
+// move is a pointer move but every comparison has to go out to the string.
+//
+//     multikey_quicksort  Bentley and Sedgewick's 3-way radix quicksort: it
+//                         partitions on one character at a time, and only
+//                         the keys equal on it go on to the next character
+//     msd_radix_cached    MSD radix sort which keeps the next PREFIXCACHE
+//                         characters of every string packed in a word beside
+//                         its pointer, so it only goes out to the strings
+//                         once per PREFIXCACHE levels instead of every level
+//     burstsort           Sinha and Zobel's burst trie: strings are inserted
+//                         into buckets at the leaves of a trie, a bucket that
+//                         grows past BURSTLIMIT bursts into a new trie node,
+//                         and the small buckets are then sorted in order
+//
+// besides comparisons and bytes moved, every engine counts character
+// inspections, the characters it reads out of the strings.
+//
+// the generated names are built like the ones in assignment #1: a prefix
+// shared by many keys ("The ", "Simpson Strap Tie ", ...) chosen with a skew,
+// some words, a suffix and usually a number, so they have the long common
+// prefixes of real names.  the orders are the generated order, sorted and
+// reverse sorted.
+//
+// Jon Bentley and Robert Sedgewick, "Fast Algorithms for Sorting and
+// Searching Strings": https://www.cs.princeton.edu/~rs/strings/
+// Ranjan Sinha and Justin Zobel, "Cache-Conscious Sorting of Large Sets of
+// Strings with Dynamic Tries", ACM JEA 9, 2004
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __stringSort__
+#define __stringSort__
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <vector>
+#include "sortFunctor.hpp"
+
+#define STRINGINSERTION 16 // string sorts hand ranges this small to insertion sort
+#define PREFIXCACHE 8      // characters msd radix caches per string, one word's worth
+#define BURSTLIMIT 8192    // strings a burst trie bucket holds before it bursts
+#define NUMBERED 75        // percent of generated names that end in a number
+
+typedef const char *stringKey;
+
+enum class StringSorts : int { MULTIKEY, MSDCACHED, BURST };
+const std::array<StringSorts, 3> allStringSorts = {StringSorts::MULTIKEY, StringSorts::MSDCACHED,
+                                                   StringSorts::BURST};
+const std::array<std::string, 3> stringSortNames = {"multikey_quicksort", "msd_radix_cached", "burstsort"};
+static constexpr int cast(StringSorts a) { return static_cast<int>(a); }
+
+// the initial orders the string sorts are run on
+const std::array<Orders, 3> stringOrders = {Orders::UNIFORM, Orders::FORWARD, Orders::REVERSE};
+
+// one name-like key, drawn from rng
+static std::string generateName(xoshiro256 &rng) {
+    static const char *prefixes[] = {"The ", "Simpson Strap Tie ", "3-5/8\" 20Ga ", "5/8\" FC-X Gyp. Bd. ",
+                                     "#8x", "2\"x6\" Joist Hanger ", "Tongue and Groove ", "Sawdust Brothers ",
+                                     "Rack 'em & Tack 'em ", "Soul Plate ", "22 caliber PAF ", "You've got "};
+    static const char *words[] = {"Stud", "Track", "Strap", "Tie", "Joist", "Hanger", "Shingles", "Plinth",
+                                  "Dovetail", "Joint", "Groove", "Flashing", "Plate", "Board", "Screw",
+                                  "Anchor", "Bracket", "Rail", "Post", "Beam", "Mob", "Brothers"};
+    static const char *suffixes[] = {"", " Inc.", " LLC", " & Sons", " Partners", " (box of 100)",
+                                     " (box of 400)", " 10'", " 4x8"};
+    const size_t P = sizeof(prefixes) / sizeof(*prefixes), W = sizeof(words) / sizeof(*words);
+    const size_t S = sizeof(suffixes) / sizeof(*suffixes);
+    // squaring the uniform draw makes the first prefixes much more common
+    double u = rng.unit();
+    std::string name = prefixes[size_t(u * u * P)];
+    for (uint64_t w = rng.below(3) + 1; w > 0; w--) {
+        name += words[rng.below(W)];
+        if (w > 1) name += ' ';
+    }
+    name += suffixes[rng.below(S)];
+    if (rng.below(100) < NUMBERED) name += " " + std::to_string(rng.below(100000));
+    return name;
+}
+
+// the string input sets for one size, shared read-only by every copy of a
+// sorter: the generated names in one arena, and pointers to them in each order
+class stringInputs {
+    public:
+    const indexType N;
+    const uint64_t seed;
+    size_t keyBytes = 0;   // characters in all of the keys, without terminators
+
+    stringInputs(indexType N, uint64_t seed) : N(N), seed(seed) {
+        xoshiro256 rng(mixSeed(seed, N));
+        std::vector<size_t> offsets(N);
+        for (indexType i = 0; i < N; i++) {
+            std::string name = generateName(rng);
+            offsets[i] = arena.size();
+            arena.insert(arena.end(), name.begin(), name.end());
+            arena.push_back('\0');
+            keyBytes += name.size();
+        }
+        generated.resize(N);
+        for (indexType i = 0; i < N; i++) generated[i] = arena.data() + offsets[i];
+        ascending = generated;
+        std::sort(ascending.begin(), ascending.end(),
+                  [](stringKey a, stringKey b) { return std::strcmp(a, b) < 0; });
+        descending.assign(ascending.rbegin(), ascending.rend());
+    }
+
+    const stringKey *keys(Orders o) const {
+        switch (o) {
+            case Orders::FORWARD: return ascending.data();
+            case Orders::REVERSE: return descending.data();
+            default:              return generated.data();
+        }
+    }
+    const stringKey *sorted() const { return ascending.data(); }
+
+    private:
+    std::vector<char> arena;
+    std::vector<stringKey> generated, ascending, descending;
+};
+
+// runs the string engines the way sortFunctor runs the integer ones: one
+// counted run, then the timed repetitions on a barePolicy twin
+template <class Counting> struct basicStringSorter;
+typedef basicStringSorter<countingPolicy> stringSorter;
+
+template <class Counting>
+struct basicStringSorter {
+    typedef basicStringSorter<barePolicy> bareFunctor;
+    typedef void (basicStringSorter::*sortFunction)(stringKey *, indexType);
+    countType comparisons, inspections, bytesMoved;
+    sortFunction sorter;
+    indexType N;
+    std::vector<stringKey> data;
+    std::shared_ptr<stringInputs> inputs;
+    bool verbose;
+    unsigned warmups = 0;    // untimed runs of each cell before timing it
+    unsigned repetitions = 1;// timed runs of each cell, each on a fresh copy
+    std::unique_ptr<bareFunctor> bare;      // untimed twin, counting sorters only
+    perfCounters counters;                  // hardware counters around the sort
+
+    basicStringSorter(indexType N = 100, bool verbose = false, uint64_t seed = randomSeed()) {
+        this->verbose = verbose;
+        this->N = N;
+        inputs = std::make_shared<stringInputs>(N, seed);
+        if(verbose) std::cout << "string input sets of size " << N << ", seed " << seed << std::endl;
+        data.resize(N);
+    }
+
+    // copies share the input sets, as sortFunctor's do
+    basicStringSorter(const basicStringSorter &other, bool verbose = false) { share(other, verbose); }
+    template <class Other>
+    basicStringSorter(const basicStringSorter<Other> &other, bool verbose = false) { share(other, verbose); }
+    basicStringSorter &operator=(const basicStringSorter &) = delete;
+
+    private:
+    template <class Other> friend struct basicStringSorter;
+    template <class Other>
+    void share(const basicStringSorter<Other> &other, bool verbose) {
+        this->verbose = verbose;
+        N           = other.N;
+        warmups     = other.warmups;
+        repetitions = other.repetitions;
+        inputs      = other.inputs;
+        data.resize(N);
+    }
+
+    public:
+
+    // select the sorting algorithm and clear the counters
+    void select(StringSorts S) {
+        comparisons = 0;
+        inspections = 0;
+        bytesMoved  = 0;
+        switch (S) {
+            case StringSorts::MULTIKEY:  sorter = &basicStringSorter::multikeyQuicksort; break;
+            case StringSorts::MSDCACHED: sorter = &basicStringSorter::msdRadixCached;    break;
+            case StringSorts::BURST:     sorter = &basicStringSorter::burstSort;         break;
+        }
+    }
+
+    // perform one sort on a fresh copy of the input, verify it and return the
+    // time elapsed
+    Clock::duration timeSort(StringSorts S, Orders O) {
+        select(S);
+        const stringKey *input = inputs->keys(O);
+        std::copy(input, input + N, data.begin());
+        counters.start();
+        Timer startTime = std::chrono::system_clock::now();
+        (*this.*sorter)(data.data(), N);
+        Timer endTime   = std::chrono::system_clock::now();
+        counters.stop();
+        // equal strings may be different copies, so compare the characters
+        const stringKey *sorted = inputs->sorted();
+        for (indexType i = 0; i < N; i++)
+            if (std::strcmp(data[i], sorted[i]) != 0) {
+                std::cout << "[error: sort didn't sort at " << i << ": " << data[i] << "] ";
+                break;
+            }
+        return endTime - startTime;
+    }
+
+    static std::string header() {
+        return "size,sort,initial_order,ms_elapsed,compares,inspections,bytes_moved,key_bytes,"
+               "ms_counted,reps,ms_min,ms_median,ms_p95,ms_stddev" + perfCounters::header(DELIMITER) + ",seed";
+    }
+
+    std::string operator()(StringSorts S, Orders O) {
+        std::ostringstream buffer;
+        if (verbose) std::cout << "sort: N=" << N << ", " << orderNames[cast(O)] << ", "
+                               << stringSortNames[cast(S)] << "... ";
+        std::cout.flush();
+        auto counted = timeSort(S, O);
+        std::vector<double> times;
+        perfCounters *hardware = &counters;
+        if (Counting::counts) {
+            if (!bare) bare.reset(new bareFunctor(*this));
+            for (unsigned w = 0; w < warmups; w++) bare->timeSort(S, O);
+            for (unsigned r = 0; r < repetitions; r++) times.push_back(bare->timeSort(S, O).count());
+            hardware = &bare->counters;
+        } else times.push_back(counted.count());
+        timingStats stats(times);
+        buffer << std::fixed << std::setprecision(0);
+        buffer << N << DELIMITER << stringSortNames[cast(S)] << DELIMITER << orderNames[cast(O)] << DELIMITER
+               << stats.median << DELIMITER << comparisons << DELIMITER << inspections << DELIMITER << bytesMoved
+               << DELIMITER << inputs->keyBytes << DELIMITER << counted.count()
+               << DELIMITER << times.size() << DELIMITER << stats.min << DELIMITER << stats.median
+               << DELIMITER << stats.p95 << DELIMITER << stats.stddev << hardware->csv(DELIMITER)
+               << DELIMITER << inputs->seed;
+        if (verbose) std::cout << "done: " << comparisons << " cmps, " << inspections << " chars, "
+                               << stats.median << " ms (" << counted.count() << " counted).\n";
+        return buffer.str();
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// the string sorts, all with the same parameter list
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void multikeyQuicksort(stringKey *arr, indexType n) {
+        multikeySplit(arr, n, 0);
+    }
+
+    void msdRadixCached(stringKey *arr, indexType n) {
+        if (n < 2) return;
+        cache.resize(n);
+        scratchKeys.resize(n);
+        scratchCache.resize(n);
+        msdCachedSplit(arr, cache.data(), n, 0);
+    }
+
+    void burstSort(stringKey *arr, indexType n) {
+        burstNode root;
+        for (indexType i = 0; i < n; i++) burstInsert(root, arr[i]);
+        Counting::count(bytesMoved, n * sizeof(stringKey));
+        burstCollect(root, 0, arr);
+    }
+
+    private:
+    std::vector<uint64_t> cache, scratchCache;   // msd radix's cached prefixes
+    std::vector<stringKey> scratchKeys;
+
+    // the character at depth, counted as an inspection
+    int charAt(stringKey s, indexType depth) {
+        Counting::count(inspections);
+        return static_cast<unsigned char>(s[depth]);
+    }
+
+    // compares two strings which are known to agree before depth
+    bool lessFrom(stringKey a, stringKey b, indexType depth) {
+        Counting::count(comparisons);
+        for (;; depth++) {
+            int x = charAt(a, depth), y = charAt(b, depth);
+            if (x != y) return x < y;
+            if (x == 0) return false;
+        }
+    }
+
+    void exchange(stringKey *arr, indexType a, indexType b) {
+        Counting::count(bytesMoved, 2 * sizeof(stringKey));
+        std::swap(arr[a], arr[b]);
+    }
+
+    void insertionSort(stringKey *arr, indexType n, indexType depth) {
+        for (indexType i = 1; i < n; i++) {
+            stringKey key = arr[i];
+            indexType j = i;
+            for (; j > 0 && lessFrom(key, arr[j - 1], depth); j--) arr[j] = arr[j - 1];
+            arr[j] = key;
+            Counting::count(bytesMoved, (i - j + 1) * sizeof(stringKey));
+        }
+    }
+
+    // partitions on the character at depth into <, = and > the median of
+    // three of them, sorts the outer parts on the same character and loops on
+    // the middle with the next one, unless the middle's strings have ended
+    void multikeySplit(stringKey *arr, indexType n, indexType depth) {
+        while (n > STRINGINSERTION) {
+            int a = charAt(arr[0], depth), b = charAt(arr[n / 2], depth), c = charAt(arr[n - 1], depth);
+            Counting::count(comparisons, 3);
+            int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+            indexType lt = 0, i = 0, gt = n;
+            while (i < gt) {
+                int ch = charAt(arr[i], depth);
+                Counting::count(comparisons);
+                if      (ch < pivot) exchange(arr, lt++, i++);
+                else if (ch > pivot) exchange(arr, i, --gt);
+                else i++;
+            }
+            multikeySplit(arr, lt, depth);
+            multikeySplit(arr + gt, n - gt, depth);
+            if (pivot == 0) return;
+            arr += lt;
+            n = gt - lt;
+            depth++;
+        }
+        insertionSort(arr, n, depth);
+    } // void multikeySplit
+
+    // the PREFIXCACHE characters of s from depth packed big-endian, so words
+    // compare like the strings do, and zero after the end of the string
+    uint64_t loadPrefix(stringKey s, indexType depth) {
+        uint64_t word = 0;
+        for (int i = 0; i < PREFIXCACHE; i++) {
+            int c = charAt(s, depth + i);
+            word |= uint64_t(c) << (8 * (PREFIXCACHE - 1 - i));
+            if (c == 0) break;
+        }
+        return word;
+    }
+
+    // fills the cache for the strings from depth and radix sorts them on it
+    void msdCachedSplit(stringKey *arr, uint64_t *cached, indexType n, indexType depth) {
+        for (indexType i = 0; i < n; i++) cached[i] = loadPrefix(arr[i], depth);
+        cachedRadix(arr, cached, n, depth, PREFIXCACHE - 1);
+    }
+
+    // one MSD pass on byte b of the cached words (PREFIXCACHE - 1 is the
+    // character at depth), moving each pointer with its word.  the pass never
+    // reads the strings; only a bucket which still agrees after the last
+    // cached character goes back to them, to refill its cache further on.
+    void cachedRadix(stringKey *arr, uint64_t *cached, indexType n, indexType depth, int b) {
+        if (n <= STRINGINSERTION) {
+            cachedInsertionSort(arr, cached, n, depth);
+            return;
+        }
+        indexType start[BUCKETS + 1];
+        auto digit = [&](uint64_t word) { return (word >> (8 * b)) & (BUCKETS - 1); };
+        for (;;) {
+            std::fill(start, start + BUCKETS + 1, 0);
+            for (indexType i = 0; i < n; i++) start[digit(cached[i]) + 1]++;
+            if (start[digit(cached[0]) + 1] != n) break;
+            // every string has this character: a zero means they all ended
+            // and are equal, otherwise go straight on to the next one
+            if (digit(cached[0]) == 0) return;
+            if (b-- == 0) {
+                msdCachedSplit(arr, cached, n, depth + PREFIXCACHE);
+                return;
+            }
+        }
+        for (int d = 0; d < BUCKETS; d++) start[d + 1] += start[d];
+        indexType next[BUCKETS];
+        std::copy(start, start + BUCKETS, next);
+        for (indexType i = 0; i < n; i++) {
+            indexType to = next[digit(cached[i])]++;
+            scratchKeys[to]  = arr[i];
+            scratchCache[to] = cached[i];
+        }
+        std::copy(scratchKeys.begin(), scratchKeys.begin() + n, arr);
+        std::copy(scratchCache.begin(), scratchCache.begin() + n, cached);
+        Counting::count(bytesMoved, 2 * n * (sizeof(stringKey) + sizeof(uint64_t)));
+        // bucket 0 holds strings which ended, and they are all equal
+        for (int d = 1; d < BUCKETS; d++) {
+            indexType size = start[d + 1] - start[d];
+            if (size < 2) continue;
+            if (b > 0) cachedRadix(arr + start[d], cached + start[d], size, depth, b - 1);
+            else msdCachedSplit(arr + start[d], cached + start[d], size, depth + PREFIXCACHE);
+        }
+    } // void cachedRadix
+
+    // insertion sort on the cached words, only reading the strings past the
+    // cache when two words are equal and neither string has ended
+    void cachedInsertionSort(stringKey *arr, uint64_t *cached, indexType n, indexType depth) {
+        auto less = [&](stringKey s, uint64_t w, indexType j) {
+            Counting::count(comparisons);
+            if (w != cached[j]) return w < cached[j];
+            return (w & (BUCKETS - 1)) != 0 && lessFrom(s, arr[j], depth + PREFIXCACHE);
+        };
+        for (indexType i = 1; i < n; i++) {
+            stringKey key = arr[i];
+            uint64_t word = cached[i];
+            indexType j = i;
+            for (; j > 0 && less(key, word, j - 1); j--) {
+                arr[j] = arr[j - 1];
+                cached[j] = cached[j - 1];
+            }
+            arr[j] = key;
+            cached[j] = word;
+            Counting::count(bytesMoved, (i - j + 1) * (sizeof(stringKey) + sizeof(uint64_t)));
+        }
+    }
+
+    // a burst trie node: each character leads either to a child node or to a
+    // bucket of the strings with that character at this depth.  bucket 0
+    // holds the strings which end here, which are all equal.
+    struct burstNode {
+        std::vector<stringKey> buckets[BUCKETS];
+        std::unique_ptr<burstNode> children[BUCKETS];
+    };
+
+    void burstInsert(burstNode &root, stringKey s) {
+        burstNode *node = &root;
+        indexType depth = 0;
+        int c = charAt(s, depth);
+        while (node->children[c]) {
+            node = node->children[c].get();
+            c = charAt(s, ++depth);
+        }
+        node->buckets[c].push_back(s);
+        if (c != 0 && node->buckets[c].size() > BURSTLIMIT) burst(*node, c, depth);
+    }
+
+    // replaces a full bucket with a node one character deeper, bursting that
+    // node's buckets again if they are all still too full
+    void burst(burstNode &node, int c, indexType depth) {
+        std::unique_ptr<burstNode> child(new burstNode);
+        for (stringKey s : node.buckets[c]) child->buckets[charAt(s, depth + 1)].push_back(s);
+        Counting::count(bytesMoved, node.buckets[c].size() * sizeof(stringKey));
+        std::vector<stringKey>().swap(node.buckets[c]);
+        for (int d = 1; d < BUCKETS; d++)
+            if (child->buckets[d].size() > BURSTLIMIT) burst(*child, d, depth + 1);
+        node.children[c] = std::move(child);
+    }
+
+    // walks the trie in order, copying each bucket out and sorting it from
+    // the first character its strings don't all share
+    stringKey *burstCollect(burstNode &node, indexType depth, stringKey *out) {
+        for (int c = 0; c < BUCKETS; c++) {
+            if (node.children[c]) {
+                out = burstCollect(*node.children[c], depth + 1, out);
+                continue;
+            }
+            std::vector<stringKey> &bucket = node.buckets[c];
+            std::copy(bucket.begin(), bucket.end(), out);
+            Counting::count(bytesMoved, bucket.size() * sizeof(stringKey));
+            if (c != 0) multikeySplit(out, bucket.size(), depth + 1);
+            out += bucket.size();
+        }
+        return out;
+    }
+}; // struct basicStringSorter
+#endif
@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////////////
+// verification.hpp
+// Brooklyn College CISC3130 M. Lowenthal  - Assignment #6
+//
+// checks a sort's output in one streaming pass, without a sorted copy of the
+// input to compare it to, so it works for keys from any distribution and for
+// files too big to keep a reference of.
+//
+//     multisetHash       the sum of splitmix64 of every key, with their count.
+//                        addition doesn't care about order, so the input and a
+//                        correct output hash the same, while a key lost,
+//                        duplicated or changed almost surely changes the sum.
+//     inputHashes        the multiset hash of each input set of one size,
+//                        computed once and shared like the input sets, so the
+//                        runs of a cell don't hash their input again
+//     streamingVerifier  takes the output in order, a block at a time, and
+//                        checks that no key is smaller than the one before it
+//                        while it hashes them
+//
+// the order check compares each register of keys with the same keys shifted by
+// one (AVX2 four at a time, SSE4.2 two), with the unsigned keys biased into
+// signed ones for the signed compare.
+//
+//////////////////////////////////////////////////////////////////////////////////
+#ifndef __verification__
+#define __verification__
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include "inputGenerator.hpp"
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+struct multisetHash {
+    uint64_t sum = 0;
+    uint64_t count = 0;
+
+    void add(sortType key) {
+        sum += splitmix64(key);
+        count++;
+    }
+    void add(const sortType *keys, size_t n) {
+        // four sums, so the multiplies of neighbouring keys overlap
+        uint64_t h[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            for (size_t l = 0; l < 4; l++) h[l] += splitmix64(keys[i + l]);
+        for (; i < n; i++) h[0] += splitmix64(keys[i]);
+        sum  += h[0] + h[1] + h[2] + h[3];
+        count += n;
+    }
+    bool operator==(const multisetHash &other) const { return sum == other.sum && count == other.count; }
+    bool operator!=(const multisetHash &other) const { return !(*this == other); }
+};
+
+class inputHashes {
+    public:
+    explicit inputHashes(std::shared_ptr<inputSets> inputs) : inputs(inputs) {}
+
+    const multisetHash &of(Orders o) {
+        std::call_once(hashed[cast(o)], [&] { hash[cast(o)].add(inputs->keys(o), inputs->N); });
+        return hash[cast(o)];
+    }
+
+    private:
+    std::shared_ptr<inputSets> inputs;
+    std::once_flag hashed[allOrders.size()];
+    multisetHash hash[allOrders.size()];
+};
+
+class streamingVerifier {
+    public:
+    multisetHash hash;
+
+    bool sorted() const { return inOrder; }
+
+    void add(sortType key) {
+        if (started && key < last) inOrder = false;
+        hash.add(key);
+        last = key;
+        started = true;
+    }
+
+    // the next n keys of the output
+    void add(const sortType *keys, size_t n) {
+        if (n == 0) return;
+        if (started && keys[0] < last) inOrder = false;
+        uint64_t h[4] = {0, 0, 0, 0};
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i bias = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+        __m256i descents = _mm256_setzero_si256();
+        for (; i + 4 < n; i += 4) {
+            __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + i)), bias);
+            __m256i b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + i + 1)), bias);
+            descents = _mm256_or_si256(descents, _mm256_cmpgt_epi64(a, b));
+            for (size_t l = 0; l < 4; l++) h[l] += splitmix64(keys[i + l]);
+        }
+        if (!_mm256_testz_si256(descents, descents)) inOrder = false;
+#elif defined(__SSE4_2__)
+        const __m128i bias = _mm_set1_epi64x(std::numeric_limits<int64_t>::min());
+        __m128i descents = _mm_setzero_si128();
+        for (; i + 2 < n; i += 2) {
+            __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), bias);
+            __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i + 1)), bias);
+            descents = _mm_or_si128(descents, _mm_cmpgt_epi64(a, b));
+            for (size_t l = 0; l < 2; l++) h[l] += splitmix64(keys[i + l]);
+        }
+        if (!_mm_testz_si128(descents, descents)) inOrder = false;
+#endif
+        hash.sum   += h[0] + h[1] + h[2] + h[3];
+        hash.count += i;
+        for (; i < n; i++) {
+            if (i + 1 < n && keys[i + 1] < keys[i]) inOrder = false;
+            hash.add(keys[i]);
+        }
+        last = keys[n - 1];
+        started = true;
+    }
+
+    private:
+    bool inOrder = true, started = false;
+    sortType last = 0;
+};
+#endif